@@ -0,0 +1,107 @@
+# Reports the flash and RAM use of each firmware module and of the linked
+# image, and fails the build if any of them is over its budget.
+#
+# cmake -DSIZE=<arm-none-eabi-size> -DELF=<firmware.elf> -DOBJECTS=<a.obj,b.obj,...>
+#       [-DENFORCE=OFF] [-DRECORD=<footprint_measured.cmake>] -P footprint.cmake
+#
+# ENFORCE=OFF only reports. RECORD writes the numbers as the new measurement
+# instead of checking them.
+
+include(${CMAKE_CURRENT_LIST_DIR}/footprint_budget.cmake)
+include(${CMAKE_CURRENT_LIST_DIR}/footprint_measured.cmake)
+
+if(NOT DEFINED ENFORCE)
+    set(ENFORCE ON)
+endif()
+
+string(REPLACE "," ";" OBJECTS "${OBJECTS}")
+
+# Berkeley format: text data bss dec hex filename
+execute_process(COMMAND ${SIZE} -B ${OBJECTS} ${ELF}
+                OUTPUT_VARIABLE size_out RESULT_VARIABLE size_result)
+if(NOT size_result EQUAL 0)
+    message(FATAL_ERROR "${SIZE} failed")
+endif()
+
+# Measured use plus headroom.
+function(budget_of measured percent out)
+    math(EXPR headroom "${measured} * ${percent} / 100")
+    if(headroom LESS FOOTPRINT_HEADROOM_MIN)
+        set(headroom ${FOOTPRINT_HEADROOM_MIN})
+    endif()
+    math(EXPR budget "${measured} + ${headroom}")
+    set(${out} ${budget} PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "\n" ";" size_lines "${size_out}")
+get_filename_component(elf_name ${ELF} NAME)
+set(over "")
+set(record "")
+set(report "${elf_name}: module flash/budget ram/budget\n")
+
+foreach(line ${size_lines})
+    if(NOT line MATCHES "^ *([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+[0-9]+[ \t]+[0-9a-f]+[ \t]+(.+)$")
+        continue()
+    endif()
+    math(EXPR flash "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+    math(EXPR ram "${CMAKE_MATCH_2} + ${CMAKE_MATCH_3}")
+    get_filename_component(module ${CMAKE_MATCH_4} NAME)
+    set(percent ${FOOTPRINT_HEADROOM_PERCENT})
+    if(module STREQUAL elf_name)
+        set(module TOTAL)
+        set(percent ${FOOTPRINT_TOTAL_HEADROOM_PERCENT})
+        if(flash GREATER FW_SLOT_SIZE)
+            list(APPEND over "TOTAL(slot)")
+        endif()
+    else()
+        # mute_button.cc.obj -> mute_button
+        string(REGEX REPLACE "\\..*$" "" module ${module})
+    endif()
+    string(APPEND record "set(MEASURED_${module} ${flash} ${ram})\n")
+
+    if(NOT DEFINED MEASURED_${module})
+        string(APPEND report "  ${module} ${flash}/- ${ram}/-  (not measured yet)\n")
+        continue()
+    endif()
+    # Either number can be "-", measured by other means than size -B and
+    # not comparable, so not checked.
+    list(GET MEASURED_${module} 0 measured_flash)
+    list(GET MEASURED_${module} 1 measured_ram)
+    set(flag "")
+    set(flash_budget -)
+    set(ram_budget -)
+    if(NOT measured_flash STREQUAL "-")
+        budget_of(${measured_flash} ${percent} flash_budget)
+        if(flash GREATER flash_budget)
+            set(flag "  OVER BUDGET")
+        endif()
+    endif()
+    if(NOT measured_ram STREQUAL "-")
+        budget_of(${measured_ram} ${percent} ram_budget)
+        if(ram GREATER ram_budget)
+            set(flag "  OVER BUDGET")
+        endif()
+    endif()
+    if(flag)
+        list(APPEND over ${module})
+    endif()
+    string(APPEND report "  ${module} ${flash}/${flash_budget} ${ram}/${ram_budget}${flag}\n")
+endforeach()
+
+message(STATUS "${report}")
+
+if(RECORD)
+    file(WRITE ${RECORD}
+         "# Measured flash and RAM use in bytes, see footprint_budget.cmake. Written by\n"
+         "# the mute_button_footprint_record target from ${elf_name}.\n\n"
+         "${record}")
+    message(STATUS "Measurement written to ${RECORD}")
+    return()
+endif()
+
+if(over)
+    if(ENFORCE)
+        message(FATAL_ERROR "Footprint over budget: ${over} (see cmake/footprint_budget.cmake)")
+    endif()
+    message(WARNING "Footprint over budget: ${over}, not enforced for this configuration")
+endif()
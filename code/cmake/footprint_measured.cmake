@@ -0,0 +1,13 @@
+# Measured flash and RAM use in bytes, see footprint_budget.cmake. Written by
+# the mute_button_footprint_record target from size -B on the linked ELF,
+# one entry per module in src/ plus TOTAL; modules without an entry are
+# reported but not checked until they have one. A "-" is not checked either.
+#
+# No RP2040 build has been recorded yet. Until one is, only TOTAL flash is
+# checked, from the baseline commit's mute_button.uf2: 91904 bytes, the
+# flash image in 256 byte blocks, which is what size -B counts as text +
+# data. Its RAM cannot be told from the UF2, as size -B also counts bss,
+# .heap and the stacks, so it is left unchecked.
+#
+#                          flash    ram
+set(MEASURED_TOTAL         91904    -)
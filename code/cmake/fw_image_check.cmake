@@ -0,0 +1,62 @@
+# Checks that a linked image carries the fw_image_info block for its slot,
+# the way fw_image_find_info() in src/fw_update_proto.h looks for it.
+#
+# cmake -DBIN=<firmware.bin> -DSLOT=<0|1> -P fw_image_check.cmake
+
+file(STRINGS ${CMAKE_CURRENT_LIST_DIR}/../src/fw_update_proto.h magic_define
+     REGEX "^#define FW_IMAGE_INFO_MAGIC 0x[0-9a-fA-F]+u$")
+if(NOT magic_define MATCHES "0x([0-9a-fA-F][0-9a-fA-F])([0-9a-fA-F][0-9a-fA-F])([0-9a-fA-F][0-9a-fA-F])([0-9a-fA-F][0-9a-fA-F])u$")
+    message(FATAL_ERROR "Could not read FW_IMAGE_INFO_MAGIC from src/fw_update_proto.h")
+endif()
+set(magic 0x${CMAKE_MATCH_1}${CMAKE_MATCH_2}${CMAKE_MATCH_3}${CMAKE_MATCH_4})
+string(TOLOWER "${CMAKE_MATCH_4}${CMAKE_MATCH_3}${CMAKE_MATCH_2}${CMAKE_MATCH_1}" magic_le)
+
+# Little-endian 32-bit word at hex offset pos of hex.
+function(read_le32 hex pos out)
+    string(SUBSTRING "${hex}" ${pos} 8 w)
+    string(REGEX REPLACE "^(..)(..)(..)(..)$" "0x\\4\\3\\2\\1" w "${w}")
+    math(EXPR w "${w}" OUTPUT_FORMAT HEXADECIMAL)
+    set(${out} ${w} PARENT_SCOPE)
+endfunction()
+
+file(READ ${BIN} image HEX)
+string(LENGTH "${image}" image_len)
+get_filename_component(bin_name ${BIN} NAME)
+
+set(found "")
+set(pos 0)
+while(NOT found)
+    string(SUBSTRING "${image}" ${pos} -1 rest)
+    string(FIND "${rest}" "${magic_le}" at)
+    if(at EQUAL -1)
+        break()
+    endif()
+    math(EXPR pos "${pos} + ${at}")
+    math(EXPR end "${pos} + 24")
+    # The block is word aligned; magic + slot, board, reserved + check.
+    if(end LESS_EQUAL image_len)
+        math(EXPR aligned "${pos} % 8")
+        if(aligned EQUAL 0)
+            string(SUBSTRING "${image}" ${pos} 24 block)
+            string(SUBSTRING "${block}" 8 2 slot)
+            string(SUBSTRING "${block}" 10 2 board)
+            read_le32("${block}" 16 check)
+            math(EXPR expected "(~(${magic} ^ 0x5a5aa5a5) ^ (0x${slot} << 8) ^ (0x${board} << 16)) & 0xffffffff"
+                 OUTPUT_FORMAT HEXADECIMAL)
+            if(check EQUAL expected)
+                set(found ${pos})
+            endif()
+        endif()
+    endif()
+    math(EXPR pos "${pos} + 2")
+endwhile()
+
+if(NOT found)
+    message(FATAL_ERROR "${bin_name}: no image info block, the loader and mute_update would reject it")
+endif()
+math(EXPR slot "0x${slot}")
+if(NOT slot EQUAL SLOT)
+    message(FATAL_ERROR "${bin_name}: image info block is for slot ${slot}, the image is linked for slot ${SLOT}")
+endif()
+math(EXPR offset "${found} / 2" OUTPUT_FORMAT HEXADECIMAL)
+message(STATUS "${bin_name}: image info at ${offset}, slot ${slot}, board 0x${board}")
@@ -0,0 +1,53 @@
+# Flash layout for the resident loader and the two update slots. The sizes
+# come from src/fw_update.h so the C++ and the linker scripts cannot drift.
+
+file(STRINGS ${CMAKE_CURRENT_LIST_DIR}/../src/fw_update.h fw_layout_defines
+     REGEX "^#define FW_(LOADER|SLOT)_SIZE 0x[0-9a-fA-F]+$")
+foreach(line ${fw_layout_defines})
+    string(REGEX MATCH "^#define (FW_[A-Z_]+) (0x[0-9a-fA-F]+)$" unused "${line}")
+    math(EXPR ${CMAKE_MATCH_1} "${CMAKE_MATCH_2}")
+endforeach()
+if(NOT DEFINED FW_LOADER_SIZE OR NOT DEFINED FW_SLOT_SIZE)
+    message(FATAL_ERROR "Could not read the flash layout from src/fw_update.h")
+endif()
+
+foreach(ld src/rp2_common/pico_crt0/rp2040/memmap_default.ld src/rp2_common/pico_standard_link/memmap_default.ld)
+    if(EXISTS ${PICO_SDK_PATH}/${ld})
+        set(FW_SDK_LINKER_SCRIPT ${PICO_SDK_PATH}/${ld})
+    endif()
+endforeach()
+
+# Links target into flash at offset, limited to length bytes, using the
+# SDK's default linker script with the FLASH region moved. The image info
+# block (section .fw_image_info) is kept in .rodata, --gc-sections would
+# drop it otherwise.
+function(fw_set_flash_region target offset length)
+    if(NOT FW_SDK_LINKER_SCRIPT)
+        message(FATAL_ERROR "memmap_default.ld not found in the pico-sdk")
+    endif()
+    file(READ ${FW_SDK_LINKER_SCRIPT} ld)
+    math(EXPR origin "0x10000000 + ${offset}" OUTPUT_FORMAT HEXADECIMAL)
+    string(REGEX REPLACE "FLASH\\(rx\\) *: *ORIGIN *= *0x10000000, *LENGTH *= *[0-9]+k"
+           "FLASH(rx) : ORIGIN = ${origin}, LENGTH = ${length}" moved "${ld}")
+    if(moved STREQUAL ld)
+        message(FATAL_ERROR "Unexpected FLASH region in ${FW_SDK_LINKER_SCRIPT}")
+    endif()
+    string(REGEX REPLACE "\\.rodata *: *{" ".rodata : {\n        KEEP(*(.fw_image_info))" kept "${moved}")
+    if(kept STREQUAL moved)
+        message(FATAL_ERROR "No .rodata section in ${FW_SDK_LINKER_SCRIPT}")
+    endif()
+    set(moved "${kept}")
+    set(script ${CMAKE_CURRENT_BINARY_DIR}/${target}.ld)
+    file(WRITE ${script} "${moved}")
+    pico_set_linker_script(${target} ${script})
+endfunction()
+
+# Fails the build of target if its image has no valid info block for slot,
+# i.e. one the loader and mute_update would accept.
+function(fw_check_image_info target slot)
+    add_custom_command(TARGET ${target} POST_BUILD
+        COMMAND ${CMAKE_OBJCOPY} -O binary $<TARGET_FILE:${target}> $<TARGET_FILE:${target}>.info.bin
+        COMMAND ${CMAKE_COMMAND} -DBIN=$<TARGET_FILE:${target}>.info.bin -DSLOT=${slot}
+                -P ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/fw_image_check.cmake
+        VERBATIM)
+endfunction()
@@ -0,0 +1,80 @@
+#include <stdio.h>
+
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+#include "bench.h"
+#include "clock_scale.h"
+
+#define SYSTICK_MAX 0x00ffffff
+
+struct bench_stats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+};
+
+static const char *const probe_names[BENCH_PROBE_COUNT] = {
+    "input_onpress",
+    "q_push",
+    "q_pop",
+    "hid_task",
+    "led_task",
+    "tud_descriptor_string_cb",
+};
+
+static bench_stats stats[BENCH_PROBE_COUNT];
+static uint32_t overhead = 0;
+static absolute_time_t next_report;
+
+/**
+ * @brief Starts SysTick as a free running 24-bit cycle counter and measures
+ * the cost of an empty probe, which is subtracted from every sample.
+ */
+void bench_init() {
+    systick_hw->rvr = SYSTICK_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    uint32_t start = bench_now();
+    overhead = (start - bench_now()) & SYSTICK_MAX;
+
+    for (uint8_t i = 0; i < BENCH_PROBE_COUNT; i++) stats[i] = { 0, UINT32_MAX, 0, 0 };
+    next_report = make_timeout_time_ms(BENCH_REPORT_INTERVAL_MS);
+}
+
+/**
+ * @brief Adds one sample. SysTick counts down, and wraps after 2^24 cycles,
+ * so paths longer than that are not measured correctly.
+ */
+void bench_record(bench_probe probe, uint32_t start) {
+    uint32_t cycles = (start - bench_now()) & SYSTICK_MAX;
+    cycles = cycles > overhead ? cycles - overhead : 0;
+
+    uint32_t status = save_and_disable_interrupts();
+    bench_stats &s = stats[probe];
+    s.count++;
+    s.total += cycles;
+    if (cycles < s.min) s.min = cycles;
+    if (cycles > s.max) s.max = cycles;
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Prints the cycle counts gathered so far.
+ */
+void bench_task() {
+    if (!time_reached(next_report)) return;
+    next_report = make_timeout_time_ms(BENCH_REPORT_INTERVAL_MS);
+
+    printf("bench @ %lu kHz: probe count min avg max (cycles)\n", (unsigned long) clock_scale_khz());
+    for (uint8_t i = 0; i < BENCH_PROBE_COUNT; i++) {
+        uint32_t status = save_and_disable_interrupts();
+        bench_stats s = stats[i];
+        restore_interrupts(status);
+        if (!s.count) continue;
+        printf("  %-26s %8lu %6lu %6lu %6lu\n", probe_names[i], (unsigned long) s.count,
+               (unsigned long) s.min, (unsigned long) (s.total / s.count), (unsigned long) s.max);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <hardware/structs/systick.h>
+
+// Cycle counts for the hot paths, taken with SysTick running from the
+// processor clock. Only compiled in with BENCHMARK; results are printed on
+// the debug UART every BENCH_REPORT_INTERVAL_MS.
+
+#define BENCH_REPORT_INTERVAL_MS 10000
+
+enum bench_probe : uint8_t {
+    BENCH_INPUT_ONPRESS,
+    BENCH_Q_PUSH,
+    BENCH_Q_POP,
+    BENCH_HID_TASK,
+    BENCH_LED_TASK,
+    BENCH_STRING_DESC,
+    BENCH_PROBE_COUNT
+};
+
+void bench_init();
+void bench_record(bench_probe probe, uint32_t start);
+void bench_task();
+
+static inline uint32_t bench_now() {
+    return systick_hw->cvr;
+}
+
+// Times the enclosing scope, including every early return.
+struct bench_scope {
+    bench_probe probe;
+    uint32_t start;
+    bench_scope(bench_probe p) : probe(p), start(bench_now()) {}
+    ~bench_scope() { bench_record(probe, start); }
+};
+
+#if BENCHMARK
+#define BENCH_SCOPE(probe) bench_scope bench_scope_(probe)
+#else
+#define BENCH_SCOPE(probe)
+#endif
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef _BOARD_PROFILE_H_
+#define _BOARD_PROFILE_H_
+
+#include <stdint.h>
+
+// Compile-time description of each hardware variant. A board is a case,
+// which fixes what fits inside, plus an independent set of input features.
+// The LED is the same on every board. The build picks both with BOARD_CASE and BOARD_FEATURES (see
+// CMakeLists.txt); Board<> derives the key list, the GPIO init list, the
+// bootloader-entry mask, the pin-to-action table, the event queue size and
+// the board ID from them, so features a board does not have are never
+// referenced and get dropped at link time.
+
+namespace board {
+
+enum class Action : uint8_t {
+    NONE,
+    MUTE,
+    HOOK,
+    VOLU,
+    VOLD,
+};
+
+// Hold-off windows for eager debouncing, per switch type
+constexpr uint32_t ENCODER_SW_HOLDOFF_US = 8000;
+constexpr uint32_t KAILH_HOLDOFF_US = 5000;
+
+struct Key {
+    uint8_t pin;
+    Action action;
+    uint32_t holdoff_us;
+};
+
+// LED colors in GRB format.
+struct Colors {
+    uint32_t red;
+    uint32_t yellow;
+    uint32_t green;
+    uint32_t blue;
+    uint32_t purple;
+    uint32_t startup_blink;
+};
+
+constexpr uint8_t NUM_GPIOS = 30;
+
+//--------------------------------------------------------------------+
+// LED
+//--------------------------------------------------------------------+
+// Every board carries the same single pixel on GPIO 2, in the colors picked
+// on the development board. Move these into the cases once one differs.
+struct Led {
+    static constexpr uint8_t WS2812_PIN = 2;
+    static constexpr uint8_t NUM_PIXELS = 1;
+    static constexpr bool IS_RGBW = false;
+    static constexpr Colors COLORS = {
+        .red = 0x000f00,
+        .yellow = 0x0f0f00,
+        .green = 0x0f0000,
+        .blue = 0x00000f,
+        .purple = 0x000f0f,
+        .startup_blink = 0x0f0f0f,
+    };
+};
+
+//--------------------------------------------------------------------+
+// Cases
+//--------------------------------------------------------------------+
+// Development board, no case: room for every feature.
+struct DevBoard {
+    static constexpr const char *NAME = "dev";
+    static constexpr uint8_t ID = 1;
+    static constexpr bool FITS_ENCODER = true;
+    static constexpr bool FITS_EXTRA_KEYS = true;
+};
+
+// 12 mm case: room for one key under the button cap.
+struct Case12 {
+    static constexpr const char *NAME = "12mm";
+    static constexpr uint8_t ID = 2;
+    static constexpr bool FITS_ENCODER = false;
+    static constexpr bool FITS_EXTRA_KEYS = false;
+};
+
+// 16 mm case: room for the rotary encoder, no extra keys.
+struct Case16 {
+    static constexpr const char *NAME = "16mm";
+    static constexpr uint8_t ID = 3;
+    static constexpr bool FITS_ENCODER = true;
+    static constexpr bool FITS_EXTRA_KEYS = false;
+};
+
+//--------------------------------------------------------------------+
+// Features, combined with |
+//--------------------------------------------------------------------+
+enum Feature : uint8_t {
+    MUTE_KEY = 1 << 0,      // Kailh mute key
+    ENCODER = 1 << 1,       // Rotary encoder for volume, its push switch mutes
+    EXTRA_KEYS = 1 << 2,    // Hook and volume keys
+};
+
+namespace keys {
+    constexpr Key MUTE_KEY[] = {
+        { 19, Action::MUTE, KAILH_HOLDOFF_US },
+    };
+    constexpr Key ENCODER[] = {
+        { 9, Action::MUTE, ENCODER_SW_HOLDOFF_US },
+    };
+    constexpr Key EXTRA_KEYS[] = {
+        { 21, Action::HOOK, KAILH_HOLDOFF_US },
+        { 18, Action::VOLU, KAILH_HOLDOFF_US },
+        { 20, Action::VOLD, KAILH_HOLDOFF_US },
+    };
+}
+
+constexpr uint8_t ENCODER_CLK_PIN = 7;
+constexpr uint8_t ENCODER_DT_PIN = 8;
+// Encoder steps per volume step
+constexpr long int ENCODER_THRESHOLD = 3;
+
+template <typename T, uint8_t N>
+constexpr uint8_t count_of(const T (&)[N]) {
+    return N;
+}
+
+struct ActionTable {
+    Action by_pin[NUM_GPIOS];
+};
+
+/**
+ * @brief Everything the firmware needs to know about a board, computed from
+ * its case and features at compile time.
+ */
+template <typename Case, uint8_t Features>
+struct Board : Case, Led {
+    static constexpr bool HAS_MUTE_KEY = Features & MUTE_KEY;
+    static constexpr bool HAS_ENCODER = Features & ENCODER;
+    static constexpr bool HAS_EXTRA_KEYS = Features & EXTRA_KEYS;
+
+    static constexpr uint8_t NUM_KEYS = (HAS_ENCODER ? count_of(keys::ENCODER) : 0) +
+                                        (HAS_MUTE_KEY ? count_of(keys::MUTE_KEY) : 0) +
+                                        (HAS_EXTRA_KEYS ? count_of(keys::EXTRA_KEYS) : 0);
+
+    // Reported in the update status and stamped into images, so an image is
+    // only ever installed on the board it was built for.
+    static constexpr uint8_t ID = Case::ID << 4 | Features;
+
+    // Events one key can push before hid_task() gets to take any: a mute
+    // key released after a long press pushes MUTE_UP, MUTE_DOWN, MUTE_UP,
+    // and a double press adds a HOOK_DOWN. Other keys push a press and a
+    // release.
+    static constexpr uint8_t key_burst(const Key &k) {
+        return k.action == Action::MUTE ? 3 + 1 : 2;
+    }
+
+    static constexpr uint8_t make_queue_length() {
+        uint8_t n = HAS_ENCODER ? 2 : 0;
+        for (const Key &k : KEYS) n += key_burst(k);
+        return n + 1;   // One ring entry always stays free
+    }
+
+    struct KeyList {
+        Key keys[NUM_KEYS];
+        constexpr const Key *begin() const { return keys; }
+        constexpr const Key *end() const { return keys + NUM_KEYS; }
+    };
+
+    template <uint8_t N>
+    static constexpr void append(KeyList &l, uint8_t &n, const Key (&add)[N]) {
+        for (uint8_t i = 0; i < N; i++) l.keys[n++] = add[i];
+    }
+
+    static constexpr KeyList make_keys() {
+        KeyList l = {};
+        uint8_t n = 0;
+        if (HAS_ENCODER) append(l, n, keys::ENCODER);
+        if (HAS_MUTE_KEY) append(l, n, keys::MUTE_KEY);
+        if (HAS_EXTRA_KEYS) append(l, n, keys::EXTRA_KEYS);
+        return l;
+    }
+
+    static constexpr KeyList KEYS = make_keys();
+
+    static constexpr ActionTable make_action_table() {
+        ActionTable t = {};
+        for (const Key &k : KEYS) t.by_pin[k.pin] = k.action;
+        return t;
+    }
+
+    // Holding any mute key while plugging in enters the USB bootloader.
+    static constexpr uint32_t make_boot_mask() {
+        uint32_t mask = 0;
+        for (const Key &k : KEYS) {
+            if (k.action == Action::MUTE) mask |= 1u << k.pin;
+        }
+        return mask;
+    }
+
+    static constexpr bool pins_valid() {
+        uint32_t used = 1u << Led::WS2812_PIN;
+        if (HAS_ENCODER) used |= 1u << ENCODER_CLK_PIN | 1u << ENCODER_DT_PIN;
+        for (const Key &k : KEYS) {
+            if (k.pin >= NUM_GPIOS || (used & (1u << k.pin))) return false;
+            used |= 1u << k.pin;
+        }
+        return true;
+    }
+
+    static constexpr ActionTable ACTIONS = make_action_table();
+    static constexpr uint32_t BOOT_MASK = make_boot_mask();
+    // Room for a burst from every input, see key_burst().
+    static constexpr uint8_t EVENT_QUEUE_LENGTH = make_queue_length();
+
+    static_assert(!HAS_ENCODER || Case::FITS_ENCODER, "The encoder does not fit this case");
+    static_assert(!HAS_EXTRA_KEYS || Case::FITS_EXTRA_KEYS, "The extra keys do not fit this case");
+    static_assert(pins_valid(), "Board uses a pin twice or a pin that does not exist");
+    static_assert(BOOT_MASK != 0, "Board needs a mute key or the encoder to enter the bootloader with");
+
+    /**
+     * @brief O(1) lookup of the action wired to a pin.
+     */
+    static constexpr Action action(uint8_t pin) {
+        return pin < NUM_GPIOS ? ACTIONS.by_pin[pin] : Action::NONE;
+    }
+};
+
+#ifndef BOARD_CASE
+#define BOARD_CASE DevBoard
+#endif
+#ifndef BOARD_FEATURES
+#define BOARD_FEATURES MUTE_KEY | ENCODER | EXTRA_KEYS
+#endif
+
+using Current = Board<BOARD_CASE, (BOARD_FEATURES)>;
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#include <hardware/clocks.h>
+#include <hardware/uart.h>
+#include <pico/stdlib.h>
+
+#include "clock_scale.h"
+#include "ws2812.h"
+
+static bool low = false;
+static absolute_time_t boost_until = nil_time;
+
+/**
+ * @brief Fixes up everything whose timing is derived from clk_sys or clk_peri.
+ * Timers and sleeps run from clk_ref and USB from its own PLL, so they are
+ * not affected.
+ */
+static void clock_changed() {
+    neopixel_clock_changed();
+#if LIB_PICO_STDIO_UART
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+}
+
+static void clock_set_low() {
+    neopixel_wait_idle();
+    set_sys_clock_48mhz();
+    low = true;
+    clock_changed();
+}
+
+static void clock_set_high() {
+    neopixel_wait_idle();
+    set_sys_clock_khz(CLOCK_SCALE_HIGH_KHZ, true);
+    low = false;
+    clock_changed();
+}
+
+/**
+ * @brief Runs at the high clock for at least hold_ms from now.
+ */
+void clock_scale_boost(uint32_t hold_ms) {
+    absolute_time_t until = make_timeout_time_ms(hold_ms);
+    if (absolute_time_diff_us(boost_until, until) > 0) boost_until = until;
+    if (low) clock_set_high();
+}
+
+/**
+ * @brief Drops to the low clock once the last boost has expired.
+ * 
+ * @param may_idle false keeps the current clock, e.g. while not mounted.
+ * Without CLOCK_SCALING the clock never drops, which makes boosts no-ops.
+ */
+void clock_scale_task(bool may_idle) {
+#if CLOCK_SCALING
+    if (!low && may_idle && time_reached(boost_until)) clock_set_low();
+#else
+    (void) may_idle;
+#endif
+}
+
+/**
+ * @brief Returns the current system clock in kHz.
+ */
+uint32_t clock_scale_khz() {
+    return low ? CLOCK_SCALE_LOW_KHZ : CLOCK_SCALE_HIGH_KHZ;
+}
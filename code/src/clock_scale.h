@@ -0,0 +1,16 @@
+#ifndef _CLOCK_SCALE_H_
+#define _CLOCK_SCALE_H_
+
+#include <stdint.h>
+
+// System clock while something is going on, and while idle. The high clock
+// is the one the SDK brought the chip up at. The idle clock comes straight
+// from the USB PLL, so the system PLL can be powered down.
+#define CLOCK_SCALE_HIGH_KHZ SYS_CLK_KHZ
+#define CLOCK_SCALE_LOW_KHZ 48000
+
+void clock_scale_boost(uint32_t hold_ms);
+void clock_scale_task(bool may_idle);
+uint32_t clock_scale_khz();
+
+#endif
@@ -0,0 +1,107 @@
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <pico/time.h>
+
+#include "eager_button.h"
+#include "input_trace.h"
+
+struct eager_button {
+    button_t button;
+    void (*onchange)(button_t *);
+    uint32_t holdoff_us;
+    volatile bool holding;  // Inside the hold-off window, edges are ignored
+};
+
+static eager_button buttons[MAX_EAGER_BUTTONS];
+static uint8_t button_count = 0;
+static uint32_t pin_mask = 0;
+
+static int64_t holdoff_expired(alarm_id_t id, void *user_data);
+
+/**
+ * @brief Reports a new level and opens the hold-off window.
+ */
+static void report(eager_button *eb, bool level) {
+    if (level == eb->button.state) return;
+
+    eb->button.state = level;
+    eb->holding = true;
+    if (add_alarm_in_us(eb->holdoff_us, holdoff_expired, eb, true) < 0) {
+        eb->holding = false;
+    }
+    eb->onchange(&eb->button);
+}
+
+/**
+ * @brief Closes the hold-off window. The pin is resampled so that a release
+ * (or press) that happened inside the window is not lost.
+ */
+static int64_t holdoff_expired(alarm_id_t id, void *user_data) {
+    eager_button *eb = static_cast<eager_button *>(user_data);
+    eb->holding = false;
+    report(eb, gpio_get(eb->button.pin));
+    return 0;
+}
+
+/**
+ * @brief Raw GPIO interrupt handler for all eager buttons. Acknowledges the
+ * events itself so they never reach the default GPIO callback. Every edge,
+ * bounces included, goes into the input trace.
+ */
+static void eager_button_irq() {
+    for (uint8_t i = 0; i < button_count; i++) {
+        eager_button *eb = &buttons[i];
+        uint32_t events = gpio_get_irq_event_mask(eb->button.pin);
+        if (!events) continue;
+        gpio_acknowledge_irq(eb->button.pin, events);
+        INPUT_TRACE_GPIO(eb->button.pin, events, gpio_get(eb->button.pin));
+
+        if (eb->holding) continue;
+
+        // Go by the edge direction, by the time we read the pin it may
+        // already have bounced back.
+        bool level;
+        if ((events & GPIO_IRQ_EDGE_FALL) && !(events & GPIO_IRQ_EDGE_RISE)) level = false;
+        else if ((events & GPIO_IRQ_EDGE_RISE) && !(events & GPIO_IRQ_EDGE_FALL)) level = true;
+        else level = gpio_get(eb->button.pin);
+
+        report(eb, level);
+    }
+}
+
+/**
+ * @brief Sets up an active low switch on a pin with eager-edge debouncing.
+ * Interrupts are not enabled until eager_buttons_enable() is called.
+ *
+ * @param holdoff_us How long to ignore the pin after each reported edge;
+ * should cover the worst case bounce of the switch.
+ * @return button_t* The button passed to onchange, or NULL if the table is full.
+ */
+button_t *create_eager_button(uint8_t pin, uint32_t holdoff_us, void (*onchange)(button_t *)) {
+    if (button_count >= MAX_EAGER_BUTTONS) return nullptr;
+
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    gpio_pull_up(pin);
+
+    eager_button *eb = &buttons[button_count++];
+    eb->button.pin = pin;
+    eb->button.state = true;    // Released; the pull-up may not have settled yet
+    eb->onchange = onchange;
+    eb->holdoff_us = holdoff_us;
+    eb->holding = false;
+    pin_mask |= 1u << pin;
+
+    return &eb->button;
+}
+
+/**
+ * @brief Installs the shared interrupt handler for every button created so far.
+ */
+void eager_buttons_enable() {
+    gpio_add_raw_irq_handler_masked(pin_mask, eager_button_irq);
+    for (uint8_t i = 0; i < button_count; i++) {
+        gpio_set_irq_enabled(buttons[i].button.pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true);
+    }
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
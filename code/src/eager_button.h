@@ -0,0 +1,17 @@
+#ifndef _EAGER_BUTTON_H_
+#define _EAGER_BUTTON_H_
+
+#include <stdint.h>
+#include "button.h"
+
+#define MAX_EAGER_BUTTONS 8
+
+// Eager-edge alternative to the button library's settle-then-report
+// debouncing: the first edge on a pin is reported straight away, then the
+// pin is ignored for its hold-off window and resampled when it ends.
+// Callbacks get a button_t with pin and state filled in, like create_button().
+
+button_t *create_eager_button(uint8_t pin, uint32_t holdoff_us, void (*onchange)(button_t *));
+void eager_buttons_enable();
+
+#endif
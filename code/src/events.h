@@ -0,0 +1,22 @@
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+// Input events, queued by the button and encoder callbacks and turned into
+// HID reports by hid_task(). The queue lives in mute_button.cc and is sized
+// by board::Current::EVENT_QUEUE_LENGTH.
+enum class Event {
+    NOTHING,
+    MUTE_DOWN,
+    MUTE_UP,
+    HOOK_DOWN,
+    HOOK_UP,
+    VOLU_DOWN,
+    VOLD_DOWN,
+    VOL_RELEASE
+};
+
+void q_push(Event e);
+Event q_peek(void);
+Event q_pop(void);
+
+#endif
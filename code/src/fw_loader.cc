@@ -0,0 +1,48 @@
+// Resident loader. Sits in the first FW_LOADER_SIZE bytes of flash, right
+// behind boot2, and is never rewritten by in-band updates. On every reset it
+// picks slot A or B from the update metadata, arms the watchdog for images
+// on trial, and starts the image the way boot2 would have.
+
+#include <hardware/regs/addressmap.h>
+#include <hardware/regs/m0plus.h>
+#include <hardware/structs/scb.h>
+#include <hardware/structs/systick.h>
+#include <hardware/watchdog.h>
+#include <pico/bootrom.h>
+
+#include "fw_meta.h"
+#include "fw_update.h"
+
+/**
+ * @brief Hands the core over to the image in a slot. Interrupts the loader
+ * may have enabled are switched off, but PRIMASK is left clear: the image's
+ * crt0 expects to start with interrupts enabled, as it does after boot2.
+ */
+static void __attribute__((noreturn)) start_image(uint8_t slot) {
+    const uint32_t *vectors = reinterpret_cast<const uint32_t *>(XIP_BASE + FW_SLOT_OFFSET(slot) + FW_VECTOR_OFFSET);
+
+    systick_hw->csr = 0;
+    *reinterpret_cast<volatile uint32_t *>(PPB_BASE + M0PLUS_NVIC_ICER_OFFSET) = 0xffffffff;
+    *reinterpret_cast<volatile uint32_t *>(PPB_BASE + M0PLUS_NVIC_ICPR_OFFSET) = 0xffffffff;
+
+    scb_hw->vtor = reinterpret_cast<uintptr_t>(vectors);
+    asm volatile(
+        "msr msp, %0\n"
+        "bx %1\n"
+        : : "r"(vectors[0]), "r"(vectors[1]));
+    __builtin_unreachable();
+}
+
+int main() {
+    bool trial;
+    int slot = fw_meta_select_slot(&trial);
+
+    // Nothing to start: wait for an image over BOOTSEL.
+    if (slot < 0) reset_usb_boot(0, 0);
+
+    // An image on trial that does not get mounted in time is reset, and
+    // fw_meta_select_slot() then goes back to the previous one.
+    if (trial) watchdog_enable(FW_TRIAL_TIMEOUT_MS, true);
+
+    start_image(slot);
+}
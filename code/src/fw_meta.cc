@@ -0,0 +1,147 @@
+#include <stddef.h>
+#include <string.h>
+
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include <hardware/regs/addressmap.h>
+
+#include "fw_meta.h"
+#include "fw_update.h"
+
+// Two sectors, written alternately. A record only counts once its check
+// word is in place, so the previous record survives a power loss during
+// the write of the next one and every switch is a single atomic step.
+#define FW_META_OFFSET (PICO_FLASH_SIZE_BYTES - 2 * FLASH_SECTOR_SIZE)
+#define FW_META_MAGIC 0x4d425550
+
+static_assert(FW_SLOT_OFFSET(2) <= FW_META_OFFSET, "Slots overlap the metadata sectors");
+static_assert(FW_LOADER_SIZE % FLASH_SECTOR_SIZE == 0 && FW_SLOT_SIZE % FLASH_SECTOR_SIZE == 0,
+              "Loader and slots must be whole sectors");
+
+static const fw_meta *meta_sector(uint8_t i) {
+    return reinterpret_cast<const fw_meta *>(XIP_BASE + FW_META_OFFSET + i * FLASH_SECTOR_SIZE);
+}
+
+static uint32_t meta_check(const fw_meta *m) {
+    return fw_crc32(0, reinterpret_cast<const uint8_t *>(m), offsetof(fw_meta, check));
+}
+
+static bool meta_valid(const fw_meta *m) {
+    return m->magic == FW_META_MAGIC && m->check == meta_check(m) && m->active < 2;
+}
+
+/**
+ * @brief Returns the sector holding the newest valid record, or -1 if
+ * neither holds one.
+ */
+static int meta_newest() {
+    bool valid0 = meta_valid(meta_sector(0));
+    bool valid1 = meta_valid(meta_sector(1));
+    if (valid0 && valid1) {
+        return static_cast<int32_t>(meta_sector(1)->seq - meta_sector(0)->seq) > 0 ? 1 : 0;
+    }
+    return valid0 ? 0 : valid1 ? 1 : -1;
+}
+
+/**
+ * @brief Reads the newest metadata record.
+ *
+ * @return false if there is none, m then describes a device that was
+ * flashed by hand: slot A active, nothing pending.
+ */
+bool fw_meta_read(fw_meta *m) {
+    int i = meta_newest();
+    if (i < 0) {
+        *m = {};
+        m->state = MetaState::NONE;
+        return false;
+    }
+    *m = *meta_sector(i);
+    return true;
+}
+
+/**
+ * @brief Writes m as the newest record, into the sector not holding the
+ * current one. Fills in magic, seq and check.
+ */
+void fw_meta_write(fw_meta *m) {
+    int newest = meta_newest();
+    uint8_t target = newest == 0 ? 1 : 0;
+
+    m->magic = FW_META_MAGIC;
+    m->seq = newest < 0 ? 1 : meta_sector(newest)->seq + 1;
+    m->check = meta_check(m);
+
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xff, sizeof(page));
+    memcpy(page, m, sizeof(*m));
+
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(FW_META_OFFSET + target * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    flash_range_program(FW_META_OFFSET + target * FLASH_SECTOR_SIZE, page, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+}
+
+/**
+ * @brief Checks that a slot starts with a plausible vector table: a stack
+ * pointer in SRAM and a reset handler inside the slot.
+ */
+bool fw_slot_bootable(uint8_t slot) {
+    const uint32_t *vectors = reinterpret_cast<const uint32_t *>(XIP_BASE + FW_SLOT_OFFSET(slot) + FW_VECTOR_OFFSET);
+    uint32_t base = FW_LINK_BASE + FW_SLOT_OFFSET(slot);
+    return vectors[0] > SRAM_BASE && vectors[0] <= SRAM_END &&
+           (vectors[1] & 1) && vectors[1] > base && vectors[1] < base + FW_SLOT_SIZE;
+}
+
+/**
+ * @brief Checks a staged image against the CRC recorded when it was
+ * received, and that it was linked for the slot it sits in.
+ */
+static bool staged_image_valid(uint8_t slot, uint32_t size, uint32_t crc) {
+    if (size == 0 || size > FW_SLOT_SIZE) return false;
+    const uint8_t *image = reinterpret_cast<const uint8_t *>(XIP_BASE + FW_SLOT_OFFSET(slot));
+    const fw_image_info *info = fw_image_find_info(image, size);
+    return fw_crc32(0, image, size) == crc && info && info->slot == slot && fw_slot_bootable(slot);
+}
+
+/**
+ * @brief Picks the slot to start and records the transition. Runs in the
+ * loader on every reset, so rollback does not depend on the new image.
+ *
+ * @param trial Set if the image is on trial: the caller arms the watchdog,
+ * and the image confirms itself once mounted (fw_update_confirm()).
+ * @return int Slot to start, or -1 if neither slot holds an image.
+ */
+int fw_meta_select_slot(bool *trial) {
+    fw_meta m;
+    fw_meta_read(&m);
+    uint8_t active = m.active;
+    uint8_t other = active ^ 1;
+    *trial = false;
+
+    switch (m.state) {
+        case MetaState::PENDING:
+            if (staged_image_valid(other, m.size, m.crc)) {
+                m.state = MetaState::TESTING;
+                fw_meta_write(&m);
+                *trial = true;
+                return other;
+            }
+            m.state = MetaState::BAD_IMAGE;
+            fw_meta_write(&m);
+            break;
+
+        case MetaState::TESTING:
+            // The image on trial was reset before it got mounted.
+            m.state = MetaState::REVERTED;
+            fw_meta_write(&m);
+            break;
+
+        default:
+            break;
+    }
+
+    if (fw_slot_bootable(active)) return active;
+    if (fw_slot_bootable(other)) return other;
+    return -1;
+}
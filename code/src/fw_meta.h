@@ -0,0 +1,37 @@
+#ifndef _FW_META_H_
+#define _FW_META_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Slot switch state machine, persisted in the metadata sectors.
+ *
+ * NONE -> (image staged) -> PENDING -> (loader) -> TESTING -> (mounted) -> CONFIRMED
+ *                              |                       \-> (reset before mount) -> REVERTED
+ *                              \-> (CRC fails in the loader) -> BAD_IMAGE
+ */
+enum class MetaState : uint32_t {
+    NONE,
+    PENDING,
+    TESTING,
+    CONFIRMED,
+    REVERTED,
+    BAD_IMAGE,
+};
+
+struct fw_meta {
+    uint32_t magic;
+    uint32_t seq;       // Newest record wins
+    MetaState state;
+    uint32_t active;    // Slot of the last image known to work
+    uint32_t size;      // Image staged in the other slot, from PENDING on
+    uint32_t crc;
+    uint32_t check;     // CRC-32 of the fields above
+};
+
+bool fw_meta_read(fw_meta *m);
+void fw_meta_write(fw_meta *m);
+bool fw_slot_bootable(uint8_t slot);
+int fw_meta_select_slot(bool *trial);
+
+#endif
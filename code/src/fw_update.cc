@@ -0,0 +1,294 @@
+#include <string.h>
+
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include <hardware/watchdog.h>
+#include <pico/time.h>
+
+#include "board_profile.h"
+#include "fw_update.h"
+#include "fw_meta.h"
+#include "me.h"
+
+#define FW_REBOOT_DELAY_MS 50
+// New images go to the slot we are not running from.
+#define FW_STAGING_SLOT (FW_IMAGE_SLOT ^ 1)
+#define FW_STAGING_OFFSET FW_SLOT_OFFSET(FW_STAGING_SLOT)
+
+static_assert(FW_UPDATE_PAGE_SIZE == FLASH_PAGE_SIZE, "Protocol page size must match the flash");
+
+// Nothing in the image reads the block from flash once the compiler has folded
+// its fields, so it lives in its own section that the linker script KEEPs (see
+// cmake/fw_layout.cmake) and is read back through a volatile pointer.
+extern const fw_image_info fw_image_info_self;
+__attribute__((used, section(".fw_image_info")))
+const fw_image_info fw_image_info_self = fw_image_info_make(FW_IMAGE_SLOT, board::Current::ID);
+
+static const fw_image_info *self_info() {
+    const fw_image_info *volatile info = &fw_image_info_self;
+    return info;
+}
+
+static fw_status status = {};
+static uint32_t image_crc = 0;
+
+static uint8_t page[FLASH_PAGE_SIZE];
+static uint16_t page_fill = 0;
+static bool page_ready = false;
+
+static bool trial = false;
+static bool confirm_pending = false;
+static bool reboot_pending = false;
+static absolute_time_t reboot_at;
+
+static const uint8_t *staging_flash() {
+    return reinterpret_cast<const uint8_t *>(XIP_BASE + FW_STAGING_OFFSET);
+}
+
+//--------------------------------------------------------------------+
+// Boot time slot handling
+//--------------------------------------------------------------------+
+/**
+ * @brief Picks up the outcome of the last switch from the metadata. The
+ * loader has already acted on it; all that is left here is to find out
+ * whether we are the image on trial.
+ */
+void fw_update_boot() {
+    fw_meta m;
+    if (!fw_meta_read(&m)) return;
+
+    switch (m.state) {
+        case MetaState::TESTING:
+            trial = m.active != FW_IMAGE_SLOT;
+            if (trial) status.boot_result = FW_BOOT_TRIAL;
+            break;
+
+        case MetaState::CONFIRMED:
+            status.boot_result = FW_BOOT_CONFIRMED;
+            break;
+
+        case MetaState::REVERTED:
+            status.boot_result = FW_BOOT_REVERTED;
+            break;
+
+        case MetaState::BAD_IMAGE:
+            status.boot_result = FW_BOOT_BAD_IMAGE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Keeps the running image. Called once the host has mounted us; the
+ * flash write itself is deferred to fw_update_task().
+ */
+void fw_update_confirm() {
+    if (trial) confirm_pending = true;
+}
+
+/**
+ * @brief Called before entering the ROM bootloader. Images copied over by
+ * hand always land in slot A, so point the loader back at it.
+ */
+void fw_update_bootsel() {
+    fw_meta m;
+    fw_meta_read(&m);
+    if (m.active == 0 && m.state != MetaState::PENDING && m.state != MetaState::TESTING) return;
+
+    m.state = MetaState::NONE;
+    m.active = 0;
+    fw_meta_write(&m);
+}
+
+//--------------------------------------------------------------------+
+// Update task
+//--------------------------------------------------------------------+
+static void program_page() {
+    uint32_t offs = FW_STAGING_OFFSET + status.written;
+
+    // Starting over the staging slot invalidates whatever was queued there.
+    if (status.written == 0) {
+        fw_meta m;
+        if (fw_meta_read(&m) && m.state == MetaState::PENDING) {
+            m.state = MetaState::NONE;
+            m.active = FW_IMAGE_SLOT;
+            fw_meta_write(&m);
+        }
+    }
+
+    uint32_t ints = save_and_disable_interrupts();
+    if (offs % FLASH_SECTOR_SIZE == 0) flash_range_erase(offs, FLASH_SECTOR_SIZE);
+    flash_range_program(offs, page, FLASH_PAGE_SIZE);
+    restore_interrupts(ints);
+
+    status.written += page_fill;
+    page_fill = 0;
+    page_ready = false;
+}
+
+static void verify_image() {
+    if (fw_crc32(0, staging_flash(), status.size) != image_crc) {
+        status.state = FW_STATE_ERROR;
+        status.error = FW_ERR_CRC;
+        return;
+    }
+
+    const fw_image_info *info = fw_image_find_info(staging_flash(), status.size);
+    if (!info || info->slot != FW_STAGING_SLOT) {
+        status.state = FW_STATE_ERROR;
+        status.error = FW_ERR_IMAGE;
+        return;
+    }
+    if (info->board != self_info()->board) {
+        status.state = FW_STATE_ERROR;
+        status.error = FW_ERR_BOARD;
+        return;
+    }
+
+    // The switch itself: from the next reset on the loader tries this image.
+    fw_meta m = {};
+    m.state = MetaState::PENDING;
+    m.active = FW_IMAGE_SLOT;
+    m.size = status.size;
+    m.crc = image_crc;
+    fw_meta_write(&m);
+    status.state = FW_STATE_READY;
+}
+
+/**
+ * @brief Does the flash work requested over USB. Called from the main loop
+ * so that tinyusb callbacks never block on an erase.
+ */
+void fw_update_task() {
+    if (confirm_pending) {
+        confirm_pending = false;
+        trial = false;
+        hw_clear_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+        fw_meta m;
+        fw_meta_read(&m);
+        m.state = MetaState::CONFIRMED;
+        m.active = FW_IMAGE_SLOT;
+        fw_meta_write(&m);
+        status.boot_result = FW_BOOT_CONFIRMED;
+    }
+
+    if (page_ready) program_page();
+
+    if (status.state == FW_STATE_VERIFYING) verify_image();
+
+    if (reboot_pending && time_reached(reboot_at)) {
+        watchdog_reboot(0, 0, 0);
+    }
+}
+
+//--------------------------------------------------------------------+
+// Feature report handlers
+//--------------------------------------------------------------------+
+static void fail(fw_update_error e) {
+    status.error = e;
+}
+
+static void on_begin(const fw_cmd_begin *cmd) {
+    // While on trial the staging slot holds the image the loader may go back to.
+    if (trial || status.state == FW_STATE_VERIFYING) return fail(FW_ERR_STATE);
+    if (cmd->size == 0 || cmd->size > FW_SLOT_SIZE) return fail(FW_ERR_TOO_BIG);
+
+    status.state = FW_STATE_RECEIVING;
+    status.error = FW_ERR_NONE;
+    status.size = cmd->size;
+    status.received = 0;
+    status.written = 0;
+    image_crc = cmd->crc;
+    page_fill = 0;
+    page_ready = false;
+}
+
+static void on_data(const fw_cmd_data *cmd) {
+    if (status.state != FW_STATE_RECEIVING) return fail(FW_ERR_STATE);
+    if (page_ready) return fail(FW_ERR_BUSY);
+    if (cmd->offset != status.received || cmd->len > FW_UPDATE_CHUNK_SIZE ||
+        page_fill + cmd->len > FLASH_PAGE_SIZE || status.received + cmd->len > status.size) {
+        return fail(FW_ERR_SEQUENCE);
+    }
+
+    memcpy(&page[page_fill], cmd->data, cmd->len);
+    page_fill += cmd->len;
+    status.received += cmd->len;
+    status.error = FW_ERR_NONE;
+
+    if (status.received == status.size) {
+        memset(&page[page_fill], 0xff, FLASH_PAGE_SIZE - page_fill);
+        page_ready = true;
+    } else if (page_fill == FLASH_PAGE_SIZE) {
+        page_ready = true;
+    }
+}
+
+static void on_commit() {
+    if (status.state != FW_STATE_RECEIVING || status.written != status.size) return fail(FW_ERR_STATE);
+    status.state = FW_STATE_VERIFYING;
+    status.error = FW_ERR_NONE;
+}
+
+static void on_abort() {
+    if (status.state == FW_STATE_VERIFYING) return fail(FW_ERR_STATE);
+    status.state = FW_STATE_IDLE;
+    status.error = FW_ERR_NONE;
+    page_fill = 0;
+    page_ready = false;
+}
+
+static void on_reboot() {
+    if (status.state != FW_STATE_READY) return fail(FW_ERR_STATE);
+    // Give the control transfer time to complete before going down.
+    reboot_at = make_timeout_time_ms(FW_REBOOT_DELAY_MS);
+    reboot_pending = true;
+}
+
+/**
+ * @brief Handles a SET_REPORT(Feature) on the update report.
+ */
+void fw_update_set_feature(uint8_t const* buffer, uint16_t bufsize) {
+    if (bufsize < 1) return;
+
+    switch (buffer[0]) {
+        case FW_CMD_BEGIN:
+            if (bufsize < sizeof(fw_cmd_begin)) return fail(FW_ERR_COMMAND);
+            on_begin(reinterpret_cast<const fw_cmd_begin *>(buffer));
+            break;
+        case FW_CMD_DATA:
+            if (bufsize < sizeof(fw_cmd_data)) return fail(FW_ERR_COMMAND);
+            on_data(reinterpret_cast<const fw_cmd_data *>(buffer));
+            break;
+        case FW_CMD_COMMIT:
+            on_commit();
+            break;
+        case FW_CMD_ABORT:
+            on_abort();
+            break;
+        case FW_CMD_REBOOT:
+            on_reboot();
+            break;
+        default:
+            fail(FW_ERR_COMMAND);
+            break;
+    }
+}
+
+/**
+ * @brief Handles a GET_REPORT(Feature) on the update report.
+ *
+ * @return uint16_t Number of bytes written to buffer.
+ */
+uint16_t fw_update_get_feature(uint8_t* buffer, uint16_t reqlen) {
+    // Always NUL-terminated, at most 7 characters of the version go out.
+    strncpy(status.version, version, sizeof(status.version) - 1);
+    status.version[sizeof(status.version) - 1] = '\0';
+    status.staging_slot = self_info()->slot ^ 1;
+    status.board = self_info()->board;
+    uint16_t len = reqlen < sizeof(status) ? reqlen : sizeof(status);
+    memcpy(buffer, &status, len);
+    return len;
+}
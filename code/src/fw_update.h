@@ -0,0 +1,33 @@
+#ifndef _FW_UPDATE_H_
+#define _FW_UPDATE_H_
+
+#include <stdint.h>
+#include <fw_update_proto.h>
+
+// Flash layout: the resident loader (fw_loader.cc) at the start of flash,
+// then slots A and B, each holding an image linked to run from that slot,
+// and the metadata sectors (fw_meta.cc) at the end of flash. Updates are
+// streamed into the slot that is not running; switching over is a single
+// metadata write. CMakeLists.txt reads the sizes from here, keep them hex.
+#define FW_LOADER_SIZE 0x8000
+#define FW_SLOT_SIZE 0x80000
+#define FW_SLOT_OFFSET(slot) (FW_LOADER_SIZE + (slot) * FW_SLOT_SIZE)
+// Images start with a copy of boot2, the vector table follows it.
+#define FW_VECTOR_OFFSET 0x100
+// Flash address images are linked against, XIP_BASE on the RP2040.
+#define FW_LINK_BASE 0x10000000u
+
+// Slot this image is linked for, set per target by CMakeLists.txt.
+#ifndef FW_IMAGE_SLOT
+#define FW_IMAGE_SLOT 0
+#endif
+
+void fw_update_boot();
+void fw_update_task();
+void fw_update_confirm();
+void fw_update_bootsel();
+
+void fw_update_set_feature(uint8_t const* buffer, uint16_t bufsize);
+uint16_t fw_update_get_feature(uint8_t* buffer, uint16_t reqlen);
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef _FW_UPDATE_PROTO_H_
+#define _FW_UPDATE_PROTO_H_
+
+// Wire format of the in-band firmware update feature report.
+// Shared by the firmware and the host tool in tools/, so it must stay free of
+// pico-sdk and tinyusb includes. Multi-byte fields are little-endian.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Must match REPORT_ID_FW_UPDATE in our_descriptor.h.
+#define FW_UPDATE_REPORT_ID 3
+// Payload size of the feature report, not counting the report ID byte.
+#define FW_UPDATE_REPORT_SIZE 63
+// Image bytes carried by a single DATA command.
+#define FW_UPDATE_CHUNK_SIZE 32
+// The device programs flash one page at a time. The host must wait for
+// `written` to catch up after every page worth of DATA commands.
+#define FW_UPDATE_PAGE_SIZE 256
+// A freshly switched image has this long to get mounted by the host before
+// the watchdog resets into the previous image.
+#define FW_TRIAL_TIMEOUT_MS 8000
+// Identifies the fw_image_info block inside an image.
+#define FW_IMAGE_INFO_MAGIC 0x4d42494du
+
+enum fw_update_cmd : uint8_t {
+    FW_CMD_BEGIN = 1,
+    FW_CMD_DATA,
+    FW_CMD_COMMIT,
+    FW_CMD_ABORT,
+    FW_CMD_REBOOT,
+};
+
+enum fw_update_state : uint8_t {
+    FW_STATE_IDLE,
+    FW_STATE_RECEIVING,
+    FW_STATE_VERIFYING,
+    FW_STATE_READY,     // Image verified, the loader switches slots on next reset
+    FW_STATE_ERROR,
+};
+
+enum fw_update_error : uint8_t {
+    FW_ERR_NONE,
+    FW_ERR_TOO_BIG,
+    FW_ERR_SEQUENCE,
+    FW_ERR_BUSY,
+    FW_ERR_CRC,
+    FW_ERR_STATE,
+    FW_ERR_COMMAND,
+    FW_ERR_IMAGE,       // Image is not built for the staging slot
+    FW_ERR_BOARD,       // Image is built for another board
+};
+
+// Outcome of the last slot switch, as recorded in the flash metadata.
+enum fw_boot_result : uint8_t {
+    FW_BOOT_NONE,
+    FW_BOOT_TRIAL,      // Running a new image that has not mounted yet
+    FW_BOOT_CONFIRMED,  // New image mounted and was kept
+    FW_BOOT_REVERTED,   // New image failed to mount, the loader went back to the previous one
+    FW_BOOT_BAD_IMAGE,  // Staged image failed its CRC in the loader and was ignored
+};
+
+#pragma pack(push, 1)
+
+struct fw_cmd_begin {
+    uint8_t cmd;
+    uint32_t size;
+    uint32_t crc;
+};
+
+struct fw_cmd_data {
+    uint8_t cmd;
+    uint8_t len;
+    uint32_t offset;
+    uint8_t data[FW_UPDATE_CHUNK_SIZE];
+};
+
+// Returned by GET_REPORT(Feature).
+struct fw_status {
+    uint8_t state;
+    uint8_t error;
+    uint8_t boot_result;
+    uint32_t size;
+    uint32_t received;
+    uint32_t written;
+    char version[8];
+    uint8_t staging_slot;   // Slot new images go to; they must be built for it
+    uint8_t board;          // Board ID, see board_profile.h; images must be built for it
+};
+
+#pragma pack(pop)
+
+// Every image carries one of these, so the loader, the update path and the
+// host tool can tell which slot it was linked for and which board it was
+// built for. Found by scanning, see fw_image_find_info().
+struct fw_image_info {
+    uint32_t magic;
+    uint8_t slot;
+    uint8_t board;
+    uint8_t reserved[2];
+    uint32_t check;
+};
+
+static_assert(sizeof(fw_cmd_data) <= FW_UPDATE_REPORT_SIZE, "DATA command does not fit the report");
+static_assert(sizeof(fw_status) <= FW_UPDATE_REPORT_SIZE, "status does not fit the report");
+static_assert(FW_UPDATE_PAGE_SIZE % FW_UPDATE_CHUNK_SIZE == 0, "chunks must tile a flash page");
+
+/**
+ * @brief Standard CRC-32 (IEEE 802.3), bitwise so it needs no table in flash.
+ *
+ * @param crc Running value, start with 0.
+ */
+static inline uint32_t fw_crc32(uint32_t crc, const uint8_t *p, size_t n) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Check word of an image info block. Depends on the other fields, so a stray
+ * copy of the magic, e.g. in a literal pool, is not mistaken for the block.
+ */
+static constexpr uint32_t fw_image_info_check(uint32_t magic, uint8_t slot, uint8_t board) {
+    return ~(magic ^ 0x5a5aa5a5u) ^ ((uint32_t)slot << 8) ^ ((uint32_t)board << 16);
+}
+
+static constexpr fw_image_info fw_image_info_make(uint8_t slot, uint8_t board) {
+    return { FW_IMAGE_INFO_MAGIC, slot, board, {}, fw_image_info_check(FW_IMAGE_INFO_MAGIC, slot, board) };
+}
+
+/**
+ * @brief Finds the image info block in an image.
+ *
+ * @return const fw_image_info* The block, or NULL if the image has none.
+ */
+static inline const fw_image_info *fw_image_find_info(const uint8_t *image, size_t size) {
+    for (size_t offs = 0; offs + sizeof(fw_image_info) <= size; offs += 4) {
+        const fw_image_info *info = reinterpret_cast<const fw_image_info *>(image + offs);
+        if (info->magic == FW_IMAGE_INFO_MAGIC && info->check == fw_image_info_check(info->magic, info->slot, info->board)) {
+            return info;
+        }
+    }
+    return nullptr;
+}
+
+#endif
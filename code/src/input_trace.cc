@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include <hardware/gpio.h>
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+
+#include "input_trace.h"
+
+static trace_record ring[INPUT_TRACE_LENGTH];
+static uint16_t ring_start = 0;
+static uint16_t ring_end = 0;
+static uint32_t dropped = 0;
+
+/**
+ * @brief Appends a timestamped record to the trace ring. Safe to call from
+ * interrupt handlers.
+ */
+void input_trace_record(uint8_t type, uint8_t arg, uint16_t value) {
+    uint32_t status = save_and_disable_interrupts();
+    ring[ring_end] = { time_us_32(), type, arg, value };
+    if (++ring_end >= INPUT_TRACE_LENGTH) ring_end = 0;
+    if (ring_end == ring_start) {
+        if (++ring_start >= INPUT_TRACE_LENGTH) ring_start = 0;
+        dropped++;
+    }
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Records an edge on a key pin. Called by whichever debouncer owns
+ * the pin, from its interrupt handler.
+ *
+ * @param events GPIO_IRQ_EDGE_FALL and/or GPIO_IRQ_EDGE_RISE.
+ */
+void input_trace_gpio(uint8_t pin, uint32_t events, bool level) {
+    uint16_t value = level ? TRACE_GPIO_LEVEL : 0;
+    if (events & GPIO_IRQ_EDGE_FALL) value |= TRACE_GPIO_FELL;
+    if (events & GPIO_IRQ_EDGE_RISE) value |= TRACE_GPIO_ROSE;
+    input_trace_record(TRACE_GPIO, pin, value);
+}
+
+/**
+ * @brief Handles a SET_REPORT(Feature) on the trace report.
+ */
+void input_trace_set_feature(uint8_t const* buffer, uint16_t bufsize) {
+    if (bufsize < 1 || buffer[0] != TRACE_CMD_CLEAR) return;
+
+    uint32_t status = save_and_disable_interrupts();
+    ring_start = ring_end = 0;
+    dropped = 0;
+    restore_interrupts(status);
+}
+
+/**
+ * @brief Handles a GET_REPORT(Feature) on the trace report by moving the
+ * oldest records out of the ring.
+ *
+ * @return uint16_t Number of bytes written to buffer.
+ */
+uint16_t input_trace_get_feature(uint8_t* buffer, uint16_t reqlen) {
+    trace_chunk chunk = {};
+
+    uint32_t status = save_and_disable_interrupts();
+    while (chunk.count < TRACE_RECORDS_PER_REPORT && ring_start != ring_end) {
+        chunk.records[chunk.count++] = ring[ring_start];
+        if (++ring_start >= INPUT_TRACE_LENGTH) ring_start = 0;
+    }
+    chunk.dropped = dropped;
+    restore_interrupts(status);
+
+    uint16_t len = reqlen < sizeof(chunk) ? reqlen : sizeof(chunk);
+    memcpy(buffer, &chunk, len);
+    return len;
+}
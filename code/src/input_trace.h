@@ -0,0 +1,24 @@
+#ifndef _INPUT_TRACE_H_
+#define _INPUT_TRACE_H_
+
+#include <stdint.h>
+#include <input_trace_proto.h>
+
+// Records in the RAM ring, the oldest are overwritten when it is full.
+#define INPUT_TRACE_LENGTH 512
+
+#if INPUT_TRACE
+#define INPUT_TRACE_RECORD(type, arg, value) input_trace_record(type, arg, value)
+#define INPUT_TRACE_GPIO(pin, events, level) input_trace_gpio(pin, events, level)
+#else
+#define INPUT_TRACE_RECORD(type, arg, value)
+#define INPUT_TRACE_GPIO(pin, events, level)
+#endif
+
+void input_trace_record(uint8_t type, uint8_t arg, uint16_t value);
+void input_trace_gpio(uint8_t pin, uint32_t events, bool level);
+
+void input_trace_set_feature(uint8_t const* buffer, uint16_t bufsize);
+uint16_t input_trace_get_feature(uint8_t* buffer, uint16_t reqlen);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _INPUT_TRACE_PROTO_H_
+#define _INPUT_TRACE_PROTO_H_
+
+// Binary format of input traces, both as read from the trace feature report
+// and as stored in capture files by tools/mute_trace. Shared with the host,
+// so no pico-sdk or tinyusb includes. Multi-byte fields are little-endian.
+
+#include <stdint.h>
+
+// Must match REPORT_ID_TRACE in our_descriptor.h.
+#define TRACE_REPORT_ID 4
+#define TRACE_REPORT_SIZE 63
+#define TRACE_RECORDS_PER_REPORT 7
+
+#define TRACE_FILE_MAGIC "MBTR"
+#define TRACE_FILE_VERSION 3
+
+enum trace_type : uint8_t {
+    TRACE_GPIO = 1,         // arg: GPIO, value: trace_gpio bits, recorded by the key debouncer
+    TRACE_ENCODER,          // arg: unused, value: encoder position (int16)
+    TRACE_SET_REPORT,       // arg: report ID, value: first byte of the output report
+    TRACE_USB,              // arg: trace_usb_event
+    TRACE_REPORT,           // arg: report ID, value: delivered input report, recorded in
+                            //   the completion callback
+    TRACE_ARM,              // arg: report ID, value: us from the last SOF to tud_hid_report()
+};
+
+enum trace_usb_event : uint8_t {
+    TRACE_USB_MOUNT = 1,
+    TRACE_USB_UMOUNT,
+    TRACE_USB_SUSPEND,
+    TRACE_USB_RESUME,
+};
+
+// Value of TRACE_GPIO records. With EAGER_DEBOUNCE these are the raw edges
+// from its interrupt handler; edges closer together than the interrupt
+// latency arrive as one interrupt with both edge bits set. Without it, they
+// are the settled levels the button library reports.
+enum trace_gpio : uint16_t {
+    TRACE_GPIO_LEVEL = 0x01,    // Pin level when the interrupt ran (0 = pressed)
+    TRACE_GPIO_FELL = 0x02,
+    TRACE_GPIO_ROSE = 0x04,
+};
+
+enum trace_cmd : uint8_t {
+    TRACE_CMD_CLEAR = 1,
+};
+
+#pragma pack(push, 1)
+
+struct trace_record {
+    uint32_t time_us;       // time_us_32() at the event, wraps every ~71 minutes
+    uint8_t type;
+    uint8_t arg;
+    uint16_t value;
+};
+
+// Returned by GET_REPORT(Feature). Reading removes the records from the ring.
+struct trace_chunk {
+    uint8_t count;
+    uint32_t dropped;       // Records overwritten before they could be read
+    trace_record records[TRACE_RECORDS_PER_REPORT];
+};
+
+struct trace_file_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(trace_record) == 8, "Trace records must stay compact");
+static_assert(sizeof(trace_chunk) <= TRACE_REPORT_SIZE, "Trace chunk does not fit the report");
+
+#endif
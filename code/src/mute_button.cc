@@ -7,9 +7,17 @@
 
 #include "encoder.h"
 #include "button.h"
+#include "eager_button.h"
 #include "ws2812.h"
 #include "our_descriptor.h"
+#include "board_profile.h"
+#include "events.h"
 #include "me.h"
+#include "fw_update.h"
+#include "report_pipeline.h"
+#include "clock_scale.h"
+#include "input_trace.h"
+#include "bench.h"
 
 // --- Debug Macro ---
 #if SERIAL_DEBUG
@@ -30,35 +38,23 @@ namespace constants {
     constexpr uint32_t BLINK_SUSPENDED_MS = 20000;
     constexpr uint32_t BLINK_STEP_MS = 60;
     constexpr uint32_t LONG_PRESS_DURATION_MS = 500;
+    constexpr uint32_t CLOCK_BOOST_EVENT_MS = 100;
+    constexpr uint32_t CLOCK_BOOST_ANIMATION_MS = 2 * BLINK_STEP_MS;
     
-    // LED Colors (GRB format)
-    constexpr uint32_t LED_COLOR_RED = 0x000f00;
-    constexpr uint32_t LED_COLOR_YELLOW = 0x0f0f00;
-    constexpr uint32_t LED_COLOR_GREEN = 0x0f0000;
-    constexpr uint32_t LED_COLOR_BLUE = 0x00000f;
-    constexpr uint32_t LED_COLOR_PURPLE = 0x000f0f;
+    // LED Colors (GRB format), the others come with the board's case
     constexpr uint32_t LED_COLOR_OFF = 0x000000;
-    constexpr uint32_t LED_COLOR_STARTUP_BLINK = 0x0f0f0f;
-    
-    // Rotary Encoder
-    constexpr uint32_t ENCODER_CLK_PIN = 7;
-    constexpr uint32_t ENCODER_DT_PIN = 8;
-    constexpr uint32_t ENCODER_SW_PIN = 9;
-    constexpr long int ENCODER_THRESHOLD = 3;
-
-    // Neopixel
-    constexpr bool IS_RGBW = false;
-    constexpr uint32_t WS2812_PIN = 2;
-    constexpr uint32_t NUM_PIXELS = 1;
-
-    // Button Pins
-    constexpr uint32_t MUTE_BUTTON_PIN = 19;
-    constexpr uint32_t HOOK_BUTTON_PIN = 21;
-    constexpr uint32_t VOLU_BUTTON_PIN = 18;
-    constexpr uint32_t VOLD_BUTTON_PIN = 20;
+
+    // Telephony report bits kept when resyncing the host; mute is a
+    // relative usage, repeating a held press would toggle it again
+    constexpr uint16_t T_REPORT_RESYNC_MASK = 0x02;
+
+    // Pins, pixels, keys and the encoder threshold come from the board
+    // profile, see board_profile.h
 
 }
 
+using Board = board::Current;
+
 // State Definitions
 enum class DeviceState : uint8_t {
     USB_ON          = 1 << 0,
@@ -71,19 +67,8 @@ enum class DeviceState : uint8_t {
 
 static uint8_t device_state_flags = 0x00;
 
-// Queue definitions
-#define Q_LENGTH 10
-
-enum class Event {
-    NOTHING,
-    MUTE_DOWN,
-    MUTE_UP,
-    HOOK_DOWN,
-    HOOK_UP,
-    VOLU_DOWN,
-    VOLD_DOWN,
-    VOL_RELEASE
-};
+// Queue definitions, sized for the inputs the board has
+#define Q_LENGTH Board::EVENT_QUEUE_LENGTH
 
 static Event queue[Q_LENGTH] = {Event::NOTHING};
 static uint8_t queue_start=0;
@@ -109,10 +94,12 @@ void led_blink(uint32_t color);
 void led_task(void);
 
 void input_init();
+void input_add_button(uint32_t pin, uint32_t holdoff_us);
 void input_onchange(rotary_encoder_t *encoder);
 void input_onpress(button_t *button);
 
 void hid_task(void);
+uint8_t event_report_id(Event e);
 
 /**
  * @brief Main program entry point.
@@ -122,27 +109,34 @@ void hid_task(void);
  */
 int main() {
 
+    fw_update_boot();
     board_init();
     me_init();
     stdio_init_all();
+#if BENCHMARK
+    bench_init();
+#endif
     led_init();
     input_init();
     tusb_init();
+    // SOF callbacks give undelivered reports a retry every frame.
+    tud_sof_cb_enable(true);
 
 
     sleep_ms(constants::USB_INIT_DELAY_MS);
-    // Check if the mute button is held down on boot to enter bootloader mode.
-    if (( ~gpio_get_all() ) & ( (1 << constants::MUTE_BUTTON_PIN) | (1 << constants::ENCODER_SW_PIN) )) {
+    // Check if a mute button is held down on boot to enter bootloader mode.
+    if (( ~gpio_get_all() ) & Board::BOOT_MASK) {
         for(uint8_t i=0; i<3; i++) {
-            led_blink(constants::LED_COLOR_PURPLE);
+            led_blink(Board::COLORS.purple);
             sleep_ms(constants::BLINK_DELAY_MS);
         }
+        fw_update_bootsel();
         reset_usb_boot(0, 0);
     }
 
-    DEBUG_PRINTF("Shhh - Mute button 0x01\nSerial: %s\n",serial_str);
+    DEBUG_PRINTF("Shhh - Mute button 0x01 (%s, board 0x%02x)\nSerial: %s\n",Board::NAME,Board::ID,serial_str);
 
-    led_blink(constants::LED_COLOR_STARTUP_BLINK);
+    led_blink(Board::COLORS.startup_blink);
     sleep_ms(constants::BLINK_DELAY_MS);
 
 
@@ -150,6 +144,11 @@ int main() {
         tud_task();
         led_task();    
         hid_task();
+        fw_update_task();
+        clock_scale_task(tud_mounted());
+#if BENCHMARK
+        bench_task();
+#endif
     }
 
     return 0;
@@ -165,6 +164,7 @@ int main() {
  * @param e The event to be added to the queue.
  */
 void q_push(Event e) {
+    BENCH_SCOPE(BENCH_Q_PUSH);
 // Use a critical section to prevent race conditions from interrupts.
     uint32_t status = save_and_disable_interrupts();
     DEBUG_PRINTF("Pushing: %d\n",static_cast<uint8_t>(e));
@@ -180,12 +180,23 @@ void q_push(Event e) {
     restore_interrupts(status);
 }
 
+/**
+ * @brief Returns the event at the front of the queue without removing it.
+ * 
+ * @return Event The front event, or Event::NOTHING if empty.
+ */
+Event q_peek(void) {
+    if( queue_start == queue_end ) return Event::NOTHING;
+    return queue[queue_start];
+}
+
 /**
  * @brief Pops an event from the circular event queue. This is an atomic operation.
  * 
  * @return Event The event from the front of the queue, or Event::NOTHING if empty.
  */
 Event q_pop(void) {
+    BENCH_SCOPE(BENCH_Q_POP);
     if( queue_start == queue_end ) return Event::NOTHING;
     // Critical section to ensure atomicity of queue access
     uint32_t status = save_and_disable_interrupts();
@@ -236,12 +247,13 @@ bool state_get(DeviceState s) {
  */
 void input_onchange(rotary_encoder_t *encoder) {
 
+    INPUT_TRACE_RECORD(TRACE_ENCODER, 0, static_cast<uint16_t>(encoder->position));
     DEBUG_PRINTF("Position: %li\n", encoder->position);
     DEBUG_PRINTF("State: %d%d\n", encoder->state & 0b10 ? 1 : 0, encoder->state & 0b01);
-    if(encoder->position > constants::ENCODER_THRESHOLD) {
+    if(encoder->position > board::ENCODER_THRESHOLD) {
         q_push(Event::VOLU_DOWN);
         DEBUG_PRINTF("VOLU_DOWN\n");
-    } else if (encoder->position < -constants::ENCODER_THRESHOLD) {
+    } else if (encoder->position < -board::ENCODER_THRESHOLD) {
         q_push(Event::VOLD_DOWN);
         DEBUG_PRINTF("VOLD_DOWN\n");
     } else return;
@@ -257,22 +269,27 @@ void input_onchange(rotary_encoder_t *encoder) {
  * @param button The button structure
  */
 void input_onpress(button_t *button) {
+    BENCH_SCOPE(BENCH_INPUT_ONPRESS);
     Event e=Event::NOTHING;
 
     DEBUG_PRINTF("Button pressed: %s\n", button->state ? "Released" : "Pressed");
+#if !EAGER_DEBOUNCE
+    // The button library keeps the pin interrupts to itself, so without
+    // eager debouncing the trace gets the settled levels it reports.
+    INPUT_TRACE_GPIO(button->pin, button->state ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL, button->state);
+#endif
     
-    switch (button->pin) {
-        case constants::HOOK_BUTTON_PIN:
+    switch (Board::action(button->pin)) {
+        case board::Action::HOOK:
             e=button->state ? Event::HOOK_UP : Event::HOOK_DOWN;
             break;
-        case constants::VOLD_BUTTON_PIN:
+        case board::Action::VOLD:
             e=button->state ? Event::VOL_RELEASE : Event::VOLD_DOWN;
             break;
-        case constants::VOLU_BUTTON_PIN:
+        case board::Action::VOLU:
             e=button->state ? Event::VOL_RELEASE : Event::VOLU_DOWN;
             break;
-        case constants::ENCODER_SW_PIN:
-        case constants::MUTE_BUTTON_PIN:
+        case board::Action::MUTE:
         {
             uint32_t current_ms = board_millis();
             static uint32_t last_pressed_ms = 0;
@@ -298,16 +315,33 @@ void input_onpress(button_t *button) {
 }
 
 /**
- * @brief Initializes all button GPIO pins defined in the BUTTON_MASK.
+ * @brief Sets up a button with the debounce mode selected at build time.
+ * 
+ * @param pin The GPIO the switch is wired to.
+ * @param holdoff_us Hold-off window of the switch, used by eager debouncing only.
  */
-void input_init() {
+void input_add_button(uint32_t pin, uint32_t holdoff_us) {
+#if EAGER_DEBOUNCE
+    create_eager_button(pin, holdoff_us, input_onpress);
+#else
+    (void) holdoff_us;
+    create_button(pin, input_onpress);
+#endif
+}
 
-    create_button(constants::ENCODER_SW_PIN, input_onpress);
-    create_button(constants::HOOK_BUTTON_PIN, input_onpress);
-    create_button(constants::MUTE_BUTTON_PIN, input_onpress);
-    create_button(constants::VOLU_BUTTON_PIN, input_onpress);
-    create_button(constants::VOLD_BUTTON_PIN, input_onpress);
-    create_encoder(constants::ENCODER_DT_PIN, constants::ENCODER_CLK_PIN, input_onchange);
+/**
+ * @brief Initializes the keys and, if the board has one, the encoder.
+ */
+void input_init() {
+    for (const board::Key &key : Board::KEYS) {
+        input_add_button(key.pin, key.holdoff_us);
+    }
+#if EAGER_DEBOUNCE
+    eager_buttons_enable();
+#endif
+    if constexpr (Board::HAS_ENCODER) {
+        create_encoder(board::ENCODER_DT_PIN, board::ENCODER_CLK_PIN, input_onchange);
+    }
     
 }
 
@@ -318,14 +352,20 @@ void input_init() {
  * @brief TinyUSB callback invoked when the device is mounted.
  */
 void tud_mount_cb(void) {
+    INPUT_TRACE_RECORD(TRACE_USB, TRACE_USB_MOUNT, 0);
     state_set(DeviceState::USB_MOUNTED);
+    report_pipeline_reset();
+    report_pipeline_resync(REPORT_ID_TELEPHONY, constants::T_REPORT_RESYNC_MASK);
+    fw_update_confirm();
 }
 
 /**
  * @brief TinyUSB callback invoked when the device is unmounted.
  */
 void tud_umount_cb(void) {
+    INPUT_TRACE_RECORD(TRACE_USB, TRACE_USB_UMOUNT, 0);
     state_unset(DeviceState::USB_ON);
+    report_pipeline_reset();
 }
 
 /**
@@ -335,6 +375,7 @@ void tud_umount_cb(void) {
  */
 void tud_suspend_cb(bool remote_wakeup_en) {
     (void) remote_wakeup_en;
+    INPUT_TRACE_RECORD(TRACE_USB, TRACE_USB_SUSPEND, 0);
     state_set(DeviceState::USB_SUSPENDED);
 }
 
@@ -342,9 +383,11 @@ void tud_suspend_cb(bool remote_wakeup_en) {
  * @brief TinyUSB callback invoked when the USB bus is resumed.
  */
 void tud_resume_cb(void) {
+    INPUT_TRACE_RECORD(TRACE_USB, TRACE_USB_RESUME, 0);
     state_unset(DeviceState::USB_SUSPENDED);
     if (tud_mounted()) {
         state_set(DeviceState::USB_MOUNTED);
+        report_pipeline_resync(REPORT_ID_TELEPHONY, constants::T_REPORT_RESYNC_MASK);
     } else {
         state_unset(DeviceState::USB_MOUNTED);
     }
@@ -359,6 +402,8 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t rep
     DEBUG_PRINTF("tud_hid_set_report_cb: itf=%u report_id=%u  report_type=%u bufsize=%u\n",itf,report_id,report_type,bufsize);    
     if (report_type == HID_REPORT_TYPE_OUTPUT && bufsize >= 1 && report_id == REPORT_ID_TELEPHONY ) {
         
+        INPUT_TRACE_RECORD(TRACE_SET_REPORT, report_id, buffer[0]);
+
         if(buffer[0] & 0x01) state_set(DeviceState::ON_CALL);
         else state_unset(DeviceState::ON_CALL);
         
@@ -374,26 +419,102 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t rep
 
     }
 
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_FW_UPDATE) {
+        fw_update_set_feature(buffer, bufsize);
+    }
+
+#if INPUT_TRACE
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_TRACE) {
+        input_trace_set_feature(buffer, bufsize);
+    }
+#endif
+
 }
 
 /**
  * @brief TinyUSB callback invoked when a GET_REPORT request is received from the host.
  * The application must fill the buffer with the report data and return its length.
+ * Input reports return the live button state, the telephony output report
+ * returns the LED state last set by the host.
  */
 uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
+    if (reqlen < 1) return 0;
+
+    if (report_type == HID_REPORT_TYPE_INPUT &&
+        (report_id == REPORT_ID_TELEPHONY || report_id == REPORT_ID_CONSUMER_CONTROL)) {
+        buffer[0] = report_pipeline_value(report_id);
+        return 1;
+    }
+    if (report_type == HID_REPORT_TYPE_OUTPUT && report_id == REPORT_ID_TELEPHONY) {
+        buffer[0] = (state_get(DeviceState::ON_CALL) ? 0x01 : 0) | (state_get(DeviceState::MUTE_ACTIVE) ? 0x02 : 0);
+        return 1;
+    }
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_FW_UPDATE) {
+        return fw_update_get_feature(buffer, reqlen);
+    }
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_STATS) {
+        return report_pipeline_get_feature(buffer, reqlen);
+    }
+#if INPUT_TRACE
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_TRACE) {
+        return input_trace_get_feature(buffer, reqlen);
+    }
+#endif
     return 0;
 }
 
 /**
- * @brief Processes events from the queue and sends HID reports to the host.
+ * @brief TinyUSB callback invoked when an IN report has been delivered to the host.
+ */
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    (void) instance;
+    if (len < 2) return;
+    report_pipeline_complete(report[0]);
+    INPUT_TRACE_RECORD(TRACE_REPORT, report[0], report[1]);
+}
+
+/**
+ * @brief TinyUSB callback invoked on every Start Of Frame once enabled.
+ * Retries reports that could not be submitted earlier.
+ */
+void tud_sof_cb(uint32_t frame_count) {
+    (void) frame_count;
+    report_pipeline_sof();
+}
+
+/**
+ * @brief Maps an event to the report it changes.
+ * 
+ * @return uint8_t The report ID, or 0 for Event::NOTHING.
+ */
+uint8_t event_report_id(Event e) {
+    switch (e) {
+    case Event::MUTE_DOWN:
+    case Event::MUTE_UP:
+    case Event::HOOK_DOWN:
+    case Event::HOOK_UP:
+        return REPORT_ID_TELEPHONY;
+    case Event::VOLD_DOWN:
+    case Event::VOLU_DOWN:
+    case Event::VOL_RELEASE:
+        return REPORT_ID_CONSUMER_CONTROL;
+    case Event::NOTHING:
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Processes events from the queue and stages HID reports for the host.
  * It handles telephony reports (mute, hook) and consumer control reports (volume).
+ * An event is only taken off the queue once the previous change to its report
+ * has been delivered, so short press/release pairs reach the host as separate
+ * reports, in order.
  */
 void hid_task() {
+    BENCH_SCOPE(BENCH_HID_TASK);
     static uint8_t t_report=0x00;
-    static uint8_t prev_t_report=t_report;
-
     static uint16_t c_report=0x00;
-    static uint16_t prev_c_report=c_report;
 
     if (!tud_ready()) {
         state_unset(DeviceState::USB_READY);
@@ -402,8 +523,11 @@ void hid_task() {
 
     state_set(DeviceState::USB_READY);
 
-    if ( !tud_hid_ready() ) return; 
-    
+    report_pipeline_submit();
+
+    uint8_t report_id = event_report_id(q_peek());
+    if ( report_id == 0 || report_pipeline_busy(report_id) ) return;
+
     switch (q_pop())
     {
     case Event::MUTE_DOWN:
@@ -431,18 +555,13 @@ void hid_task() {
     default:
         return;
     }
-    
-    if ( prev_t_report != t_report ) {
-        tud_hid_report(REPORT_ID_TELEPHONY, &t_report, 1);
-        prev_t_report = t_report;
-        return;
-    }
 
-    if ( prev_c_report != c_report ) {
-        tud_hid_report(REPORT_ID_CONSUMER_CONTROL, &c_report, 1);
-        prev_c_report = c_report;
-        return;
-    }
+    report_pipeline_stage(report_id, report_id == REPORT_ID_TELEPHONY ? t_report : c_report);
+    report_pipeline_submit();
+
+    // Only now raise the clock for whatever follows: switching waits for the
+    // LED PIO and the PLL, and the report is already armed at the low clock.
+    clock_scale_boost(constants::CLOCK_BOOST_EVENT_MS);
 
 }
 
@@ -454,6 +573,7 @@ void hid_task() {
  * It shows a "breathing" effect when idle and solid colors (red/green) for mute status during a call.
  */
 void led_task(void) {
+    BENCH_SCOPE(BENCH_LED_TASK);
     static uint32_t start_ms = board_millis();
     static LedState led_state = LedState::BREATHING;
     static LedState prev_led_state = LedState::SOLID_RED; // Force initial update
@@ -503,6 +623,11 @@ void led_task(void) {
                 }
             }
 
+            // Stay at the high clock for the length of the fade
+            if (interval_ms == constants::BLINK_STEP_MS) {
+                clock_scale_boost(constants::CLOCK_BOOST_ANIMATION_MS);
+            }
+
             uint32_t c = (fade * fade * fade) / 216; // Non-linear brightness for better effect
 
             led_set(c << 16 | c << 8 | c);
@@ -510,14 +635,14 @@ void led_task(void) {
         }
 
         case LedState::SOLID_GREEN: {
-            led_set(constants::LED_COLOR_GREEN);
+            led_set(Board::COLORS.green);
             interval_ms = constants::BLINK_STEP_MS;
             break;
 
         }
 
         case LedState::SOLID_RED: {
-            led_set(constants::LED_COLOR_RED);
+            led_set(Board::COLORS.red);
             interval_ms = constants::BLINK_STEP_MS;
             break;
         }
@@ -528,7 +653,7 @@ void led_task(void) {
  * @brief Initializes the Neopixel hardware.
  */
 void led_init() {
-    neopixel_init(constants::WS2812_PIN, constants::IS_RGBW);
+    neopixel_init(Board::WS2812_PIN, Board::IS_RGBW);
     led_set(constants::LED_COLOR_OFF);
 }    
 
@@ -538,7 +663,7 @@ void led_init() {
  * @param pixel_grb The color in GRB format (e.g., 0xGGRRBB).
  */
 void led_set(uint32_t color) {
-    for(uint8_t i=0; i<constants::NUM_PIXELS; i++) {
+    for(uint8_t i=0; i<Board::NUM_PIXELS; i++) {
         put_pixel(color);
     }
 }
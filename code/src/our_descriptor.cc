@@ -1,12 +1,24 @@
 #include "our_descriptor.h"
+#include "fw_update_proto.h"
+#include "input_trace_proto.h"
+#include "report_stats_proto.h"
 
 const uint8_t our_report_descriptor[] = {
 
     TUD_HID_REPORT_DESC_TELEPHONY( HID_REPORT_ID(REPORT_ID_TELEPHONY) ),
     TUD_HID_REPORT_DESC_CUSTOM_CONSUMER( HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL )),
+    TUD_HID_REPORT_DESC_VENDOR_FEATURE( HID_REPORT_ID(REPORT_ID_FW_UPDATE ), 0x01, FW_UPDATE_REPORT_SIZE ),
+#if INPUT_TRACE
+    TUD_HID_REPORT_DESC_VENDOR_FEATURE( HID_REPORT_ID(REPORT_ID_TRACE ), 0x02, TRACE_REPORT_SIZE ),
+#endif
+    TUD_HID_REPORT_DESC_VENDOR_FEATURE( HID_REPORT_ID(REPORT_ID_STATS ), 0x03, STATS_REPORT_SIZE ),
 
 };
 
+static_assert(REPORT_ID_FW_UPDATE == FW_UPDATE_REPORT_ID, "Host tools address the update report by number");
+static_assert(REPORT_ID_TRACE == TRACE_REPORT_ID, "Host tools address the trace report by number");
+static_assert(REPORT_ID_STATS == STATS_REPORT_ID, "Host tools address the stats report by number");
+
 const uint32_t our_report_descriptor_length = sizeof(our_report_descriptor);
 
 
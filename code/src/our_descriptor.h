@@ -8,6 +8,9 @@ enum
 {
   REPORT_ID_TELEPHONY = 1,
   REPORT_ID_CONSUMER_CONTROL,
+  REPORT_ID_FW_UPDATE,
+  REPORT_ID_TRACE,
+  REPORT_ID_STATS,
   REPORT_ID_COUNT
 };
 
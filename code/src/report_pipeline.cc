@@ -0,0 +1,244 @@
+#include <string.h>
+
+#include <tusb.h>
+#include <device/usbd_pvt.h>
+#include <pico/time.h>
+
+#include "report_pipeline.h"
+#include "our_descriptor.h"
+#include "input_trace.h"
+
+// Full speed frames are 1 ms apart.
+#define FRAME_US 1000
+
+/**
+ * @brief Latest desired state of one input report.
+ *
+ * dirty: value has not been handed to tinyusb yet.
+ * in_flight: a transfer for this report is waiting for its completion callback.
+ * resync: the pending transfer is a resync and sends value & resync_mask.
+ */
+struct report_slot {
+    uint8_t id;
+    uint8_t len;
+    uint16_t value;
+    uint16_t resync_mask;
+    uint32_t armed_us;
+    uint32_t seq;
+    bool dirty;
+    bool in_flight;
+    bool resync;
+};
+
+static report_slot slots[REPORT_PIPELINE_SLOTS] = {
+    { .id = REPORT_ID_TELEPHONY, .len = 1 },
+    { .id = REPORT_ID_CONSUMER_CONTROL, .len = 1 },
+};
+static uint32_t stage_seq = 0;
+static volatile uint32_t sof_us = 0;
+static report_stats stats = {};
+
+static report_slot *find_slot(uint8_t report_id) {
+    for (uint8_t i = 0; i < REPORT_PIPELINE_SLOTS; i++) {
+        if (slots[i].id == report_id) return &slots[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Records the new desired value of a report. Does nothing if the
+ * value is unchanged.
+ */
+void report_pipeline_stage(uint8_t report_id, uint16_t value) {
+    report_slot *s = find_slot(report_id);
+    if (!s || s->value == value) return;
+
+    s->value = value;
+    s->resync = false;
+    s->dirty = true;
+    s->seq = ++stage_seq;
+}
+
+/**
+ * @brief Checks whether the last value staged for a report has yet to reach
+ * the host. Staging again before this clears would merge the two changes.
+ */
+bool report_pipeline_busy(uint8_t report_id) {
+    report_slot *s = find_slot(report_id);
+    return s && (s->dirty || s->in_flight);
+}
+
+/**
+ * @brief Returns the latest value staged for a report, delivered or not.
+ */
+uint16_t report_pipeline_value(uint8_t report_id) {
+    report_slot *s = find_slot(report_id);
+    return s ? s->value : 0;
+}
+
+/**
+ * @brief Sends the current state of a report again so the host can catch up,
+ * e.g. after mount or resume. Nothing is added if a report is already pending,
+ * as that one carries the state anyway.
+ * 
+ * @param mask Bits to send; relative usages must not be repeated. Only the
+ * report sent is masked, the staged value stays as it is.
+ */
+void report_pipeline_resync(uint8_t report_id, uint16_t mask) {
+    report_slot *s = find_slot(report_id);
+    if (!s || s->dirty || s->in_flight) return;
+
+    s->resync = true;
+    s->resync_mask = mask;
+    s->dirty = true;
+    s->seq = ++stage_seq;
+}
+
+/**
+ * @brief Hands the oldest dirty report to tinyusb. Only one transfer is kept
+ * in flight so reports go out in the order they were staged.
+ * If tinyusb refuses it the report stays dirty and is retried on the next
+ * call, at the latest on the next SOF.
+ */
+static void submit_next() {
+    report_slot *next = nullptr;
+
+    for (uint8_t i = 0; i < REPORT_PIPELINE_SLOTS; i++) {
+        if (slots[i].in_flight) return;
+        if (slots[i].dirty && (!next || slots[i].seq < next->seq)) next = &slots[i];
+    }
+    if (!next || !tud_hid_ready()) return;
+
+    // tinyusb copies the report, so a masked copy can live on the stack.
+    uint16_t report = next->resync ? next->value & next->resync_mask : next->value;
+    if (tud_hid_report(next->id, &report, next->len)) {
+        next->dirty = false;
+        next->in_flight = true;
+        next->armed_us = time_us_32();
+
+        // Frames are exactly 1 ms apart, so this holds even if SOFs were
+        // missed while the device was busy.
+        uint16_t offset = (next->armed_us - sof_us) % FRAME_US;
+        stats.arm_offset[offset * STATS_OFFSET_BUCKETS / FRAME_US]++;
+        INPUT_TRACE_RECORD(TRACE_ARM, next->id, offset);
+    } else {
+        stats.retried++;
+    }
+}
+
+/**
+ * @brief Submits the next report from the main loop.
+ */
+void report_pipeline_submit() {
+    submit_next();
+}
+
+/**
+ * @brief Called from tud_sof_cb(). Retries a report tinyusb refused earlier.
+ */
+void report_pipeline_sof() {
+    submit_next();
+}
+
+/**
+ * @brief Marks the in-flight transfer of a report as delivered and submits
+ * whatever is queued behind it.
+ */
+void report_pipeline_complete(uint8_t report_id) {
+    report_slot *s = find_slot(report_id);
+    if (!s || !s->in_flight) return;
+
+    uint32_t latency = time_us_32() - s->armed_us;
+    if (latency > stats.latency_us_max) stats.latency_us_max = latency;
+    stats.latency_us_total += latency;
+
+    s->in_flight = false;
+    s->resync = false;
+    stats.delivered++;
+    report_pipeline_submit();
+}
+
+/**
+ * @brief Called on bus reset, mount and unmount. A transfer that was in
+ * flight will never complete, so its report is sent again.
+ */
+void report_pipeline_reset() {
+    for (uint8_t i = 0; i < REPORT_PIPELINE_SLOTS; i++) {
+        if (slots[i].in_flight) {
+            slots[i].in_flight = false;
+            slots[i].dirty = true;
+            stats.retried++;
+        }
+    }
+}
+
+/**
+ * @brief Handles a GET_REPORT(Feature) on the stats report.
+ *
+ * @return uint16_t Number of bytes written to buffer.
+ */
+uint16_t report_pipeline_get_feature(uint8_t* buffer, uint16_t reqlen) {
+    uint16_t len = reqlen < sizeof(stats) ? reqlen : sizeof(stats);
+    memcpy(buffer, &stats, len);
+    return len;
+}
+
+//--------------------------------------------------------------------+
+// SOF timestamps
+//--------------------------------------------------------------------+
+// tud_sof_cb() runs from tud_task(), up to a main loop pass after the frame
+// started, too late to tell where in the frame a report was armed. Class
+// drivers get the SOF from the USB interrupt instead, so this one claims no
+// interface and only notes the time.
+
+static void sof_driver_init() {
+}
+
+static void sof_driver_reset(uint8_t rhport) {
+    (void) rhport;
+}
+
+static uint16_t sof_driver_open(uint8_t rhport, tusb_desc_interface_t const* desc_intf, uint16_t max_len) {
+    (void) rhport;
+    (void) desc_intf;
+    (void) max_len;
+    return 0;
+}
+
+static bool sof_driver_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const* request) {
+    (void) rhport;
+    (void) stage;
+    (void) request;
+    return false;
+}
+
+static bool sof_driver_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    (void) rhport;
+    (void) ep_addr;
+    (void) result;
+    (void) xferred_bytes;
+    return false;
+}
+
+static void sof_driver_sof(uint8_t rhport, uint32_t frame_count) {
+    (void) rhport;
+    (void) frame_count;
+    sof_us = time_us_32();
+}
+
+/**
+ * @brief TinyUSB callback for application class drivers. The members are
+ * set by name because the layout of usbd_class_driver_t differs between
+ * tinyusb releases.
+ */
+usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count) {
+    static usbd_class_driver_t driver;
+    driver.init = sof_driver_init;
+    driver.reset = sof_driver_reset;
+    driver.open = sof_driver_open;
+    driver.control_xfer_cb = sof_driver_control_xfer_cb;
+    driver.xfer_cb = sof_driver_xfer_cb;
+    driver.sof = sof_driver_sof;
+    *driver_count = 1;
+    return &driver;
+}
@@ -0,0 +1,19 @@
+#ifndef _REPORT_PIPELINE_H_
+#define _REPORT_PIPELINE_H_
+
+#include <stdint.h>
+#include <report_stats_proto.h>
+
+// Input reports tracked by the pipeline, one slot per report ID.
+#define REPORT_PIPELINE_SLOTS 2
+void report_pipeline_stage(uint8_t report_id, uint16_t value);
+bool report_pipeline_busy(uint8_t report_id);
+uint16_t report_pipeline_value(uint8_t report_id);
+void report_pipeline_resync(uint8_t report_id, uint16_t mask);
+void report_pipeline_submit();
+void report_pipeline_sof();
+void report_pipeline_complete(uint8_t report_id);
+void report_pipeline_reset();
+uint16_t report_pipeline_get_feature(uint8_t* buffer, uint16_t reqlen);
+
+#endif
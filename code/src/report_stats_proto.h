@@ -0,0 +1,33 @@
+#ifndef _REPORT_STATS_PROTO_H_
+#define _REPORT_STATS_PROTO_H_
+
+// Report pipeline counters as read from the stats feature report by
+// tools/mute_trace. Shared with the host, so no pico-sdk or tinyusb
+// includes. Multi-byte fields are little-endian.
+
+#include <stdint.h>
+
+// Must match REPORT_ID_STATS in our_descriptor.h.
+#define STATS_REPORT_ID 5
+#define STATS_REPORT_SIZE 63
+
+// Histogram buckets for where in the USB frame reports get armed, each
+// 1000 / STATS_OFFSET_BUCKETS us wide.
+#define STATS_OFFSET_BUCKETS 8
+
+#pragma pack(push, 1)
+
+// Counts since power-up, returned by GET_REPORT(Feature).
+struct report_stats {
+    uint32_t delivered;         // Reports confirmed by tud_hid_report_complete_cb
+    uint32_t retried;           // Submissions refused by tinyusb or lost to a bus reset
+    uint32_t arm_offset[STATS_OFFSET_BUCKETS];  // Time from SOF to tud_hid_report()
+    uint32_t latency_us_max;    // Time from tud_hid_report() to the completion callback
+    uint64_t latency_us_total;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(report_stats) <= STATS_REPORT_SIZE, "Stats do not fit the report");
+
+#endif
@@ -62,6 +62,20 @@ enum {
     HID_INPUT        ( HID_CONSTANT | HID_ARRAY | HID_ABSOLUTE    ) ,\
   HID_COLLECTION_END \
 
+// Vendor defined feature report, used for firmware updates and input traces
+#define TUD_HID_REPORT_DESC_VENDOR_FEATURE(report_id, usage, report_size) \
+  HID_USAGE_PAGE_N ( HID_USAGE_PAGE_VENDOR, 2 )              ,\
+  HID_USAGE        ( usage                    )              ,\
+  HID_COLLECTION   ( HID_COLLECTION_APPLICATION )            ,\
+    report_id \
+    HID_USAGE        ( 0x02                                       ) ,\
+    HID_LOGICAL_MIN  ( 0x00                                       ) ,\
+    HID_LOGICAL_MAX_N( 0xff, 2                                    ) ,\
+    HID_REPORT_SIZE  ( 8                                          ) ,\
+    HID_REPORT_COUNT ( report_size                                ) ,\
+    HID_FEATURE      ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE     ) ,\
+  HID_COLLECTION_END \
+
 
 
 #endif
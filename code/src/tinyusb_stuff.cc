@@ -27,6 +27,7 @@
 #include <tusb.h>
 #include <me.h>
 #include <our_descriptor.h>
+#include "bench.h"
 
 // These IDs are bogus. If you want to distribute any hardware using this,
 // you will have to get real ones.
@@ -54,12 +55,20 @@ tusb_desc_device_t const desc_device = {
 #define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
 #define EPNUM_HID 0x81
 
+// The host takes an armed report on its next poll, so the interval bounds
+// the report latency: up to 8 ms by default, 1 ms with HID_POLL_1MS.
+#if HID_POLL_1MS
+#define HID_POLL_INTERVAL_MS 1
+#else
+#define HID_POLL_INTERVAL_MS 8
+#endif
+
 uint8_t const desc_configuration[] = {
     // Config number, interface count, string index, total length, attribute, power in mA
     TUD_CONFIG_DESCRIPTOR(1, 1, 0, CONFIG_TOTAL_LEN, 0, 200),
 
     // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(0, 0, HID_ITF_PROTOCOL_NONE, our_report_descriptor_length, EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 8)
+    TUD_HID_DESCRIPTOR(0, 0, HID_ITF_PROTOCOL_NONE, our_report_descriptor_length, EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, HID_POLL_INTERVAL_MS)
 };
 
 char const* string_desc_arr[] = {
@@ -90,12 +99,19 @@ uint8_t const* tud_hid_descriptor_report_cb(uint8_t itf) {
 }
 
 static uint16_t _desc_str[32];
+// Index whose descriptor is in _desc_str. The strings do not change once
+// tusb_init() has run, and hosts ask for the same one several times in a
+// row, so the conversion is only redone when the index changes.
+static int16_t _desc_str_index = -1;
 
 // Invoked when received GET STRING DESCRIPTOR request
 // Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
 uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    BENCH_SCOPE(BENCH_STRING_DESC);
     uint8_t chr_count;
 
+    if (index == _desc_str_index) return _desc_str;
+
     if (index == 0) {
         memcpy(&_desc_str[1], string_desc_arr[0], 2);
         chr_count = 1;
@@ -121,6 +137,7 @@ uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
 
     // first byte is length (including header), second byte is string type
     _desc_str[0] = (TUSB_DESC_STRING << 8) | (2 * chr_count + 2);
+    _desc_str_index = index;
 
     return _desc_str;
 }
@@ -9,6 +9,7 @@
 
 #include "ws2812.h"
 
+#define WS2812_FREQ 800000
 
 void put_pixel(uint32_t pixel_grb) {
     pio_sm_put_blocking(pio0, 0, pixel_grb << 8u);
@@ -19,5 +20,18 @@ void neopixel_init(uint pin, bool isRGBW) {
     int sm = 0;
     uint offset = pio_add_program(pio, &ws2812_program);
 
-    ws2812_program_init(pio, sm, offset, pin, 800000, isRGBW);
+    ws2812_program_init(pio, sm, offset, pin, WS2812_FREQ, isRGBW);
+}
+
+// Wait until the last queued pixel has been shifted out, so that a clock
+// change does not stretch a bit half way through.
+void neopixel_wait_idle() {
+    uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + 0);
+    pio0->fdebug = stall;
+    while (!(pio0->fdebug & stall)) tight_loop_contents();
+}
+
+// Recompute the bit timing after clk_sys has changed.
+void neopixel_clock_changed() {
+    pio_sm_set_clkdiv(pio0, 0, ws2812_program_clkdiv(WS2812_FREQ));
 }
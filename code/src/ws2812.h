@@ -3,5 +3,7 @@
 
 void neopixel_init(uint pin, bool isRGBW);
 void put_pixel(uint32_t pixel_grb);
+void neopixel_wait_idle();
+void neopixel_clock_changed();
 
 #endif
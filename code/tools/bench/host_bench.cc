@@ -0,0 +1,135 @@
+// Host build of the hot paths that BENCHMARK=ON times on the device with
+// SysTick: the same functions, run against the pico shim under Google
+// Benchmark. The numbers are host nanoseconds, not RP2040 cycles; they are
+// for spotting regressions from one build to the next.
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+#include "button.h"
+#include "events.h"
+#include "me.h"
+#include "our_descriptor.h"
+#include "pico_shim.h"
+#include "tusb_shim.h"
+
+// mute_button.cc
+void hid_task(void);
+void led_task(void);
+void input_onpress(button_t *button);
+
+// The report descriptor needs tinyusb's HID macros, which the shim does not
+// have; the string descriptor path never looks at it.
+const uint8_t our_report_descriptor[] = { 0 };
+const uint32_t our_report_descriptor_length = sizeof(our_report_descriptor);
+
+#define VOLU_GPIO 18
+
+// Longest wait between two LED updates while not mounted.
+#define LED_UNMOUNTED_STEP_US 100000
+
+/**
+ * @brief Lets the host take whatever report is armed, as it would on its
+ * next poll.
+ */
+static void deliver() {
+    shim_time_advance_us(8000);
+    tud_task();
+}
+
+// Starts every benchmark on a mounted device with nothing in flight.
+static void setup(const benchmark::State &) {
+    shim_reset();
+    me_init();
+    tusb_init();
+    tud_sof_cb_enable(true);
+    shim_usb_connect();
+    tud_task();
+    deliver();
+}
+
+// The LED runs its animation before the host has mounted the device.
+static void setup_unmounted(const benchmark::State &) {
+    shim_reset();
+    me_init();
+}
+
+static void drain() {
+    while (q_pop() != Event::NOTHING) {
+    }
+}
+
+static void BM_q_push_pop(benchmark::State &state) {
+    for (auto _ : state) {
+        q_push(Event::VOLU_DOWN);
+        benchmark::DoNotOptimize(q_pop());
+    }
+}
+BENCHMARK(BM_q_push_pop)->Setup(setup);
+
+// A press and a release of a volume key, and popping the two events.
+static void BM_input_onpress(benchmark::State &state) {
+    button_t button = { VOLU_GPIO, false, input_onpress };
+    for (auto _ : state) {
+        button.state = false;
+        input_onpress(&button);
+        button.state = true;
+        input_onpress(&button);
+        drain();
+    }
+}
+BENCHMARK(BM_input_onpress)->Setup(setup);
+
+static void BM_hid_task_idle(benchmark::State &state) {
+    for (auto _ : state) hid_task();
+}
+BENCHMARK(BM_hid_task_idle)->Setup(setup);
+
+// One volume event per pass, staged and armed as a consumer control report.
+// Only hid_task() is timed, not the host taking the report.
+static void BM_hid_task_event(benchmark::State &state) {
+    bool down = false;
+    for (auto _ : state) {
+        down = !down;
+        q_push(down ? Event::VOLU_DOWN : Event::VOL_RELEASE);
+        auto start = std::chrono::steady_clock::now();
+        hid_task();
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        deliver();
+    }
+}
+BENCHMARK(BM_hid_task_event)->Setup(setup)->UseManualTime();
+
+// One step of the breathing animation per pass. Time is moved past the
+// step interval outside the timed part, so every call updates the LED
+// instead of returning early.
+static void BM_led_task(benchmark::State &state) {
+    for (auto _ : state) {
+        shim_time_advance_us(LED_UNMOUNTED_STEP_US);
+        auto start = std::chrono::steady_clock::now();
+        led_task();
+        auto end = std::chrono::steady_clock::now();
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+    }
+}
+BENCHMARK(BM_led_task)->Setup(setup_unmounted)->UseManualTime();
+
+// Hosts ask for the same string several times in a row, which is served
+// from the last conversion.
+static void BM_string_desc_repeat(benchmark::State &state) {
+    for (auto _ : state) benchmark::DoNotOptimize(tud_descriptor_string_cb(2, 0x0409));
+}
+BENCHMARK(BM_string_desc_repeat)->Setup(setup);
+
+static void BM_string_desc_convert(benchmark::State &state) {
+    uint8_t index = 1;
+    for (auto _ : state) {
+        index = index == 3 ? 1 : index + 1;
+        benchmark::DoNotOptimize(tud_descriptor_string_cb(index, 0x0409));
+    }
+}
+BENCHMARK(BM_string_desc_convert)->Setup(setup);
+
+BENCHMARK_MAIN();
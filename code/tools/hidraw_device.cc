@@ -0,0 +1,54 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include <string>
+
+#include "hidraw_device.h"
+
+/**
+ * @brief Opens the given hidraw node, or the first one that belongs to a
+ * mute button if path is NULL.
+ */
+int hidraw_open(const char *path) {
+    if (path) return open(path, O_RDWR);
+
+    for (int i = 0; i < 64; i++) {
+        std::string p = "/dev/hidraw" + std::to_string(i);
+        int fd = open(p.c_str(), O_RDWR);
+        if (fd < 0) continue;
+        struct hidraw_devinfo info;
+        if (ioctl(fd, HIDIOCGRAWINFO, &info) == 0 &&
+            (uint16_t)info.vendor == USB_VID && (uint16_t)info.product == USB_PID) {
+            fprintf(stderr, "Using %s\n", p.c_str());
+            return fd;
+        }
+        close(fd);
+    }
+    errno = ENODEV;
+    return -1;
+}
+
+bool hidraw_set_feature(int fd, uint8_t report_id, const void *data, size_t len) {
+    uint8_t buf[FEATURE_REPORT_SIZE + 1] = {report_id};
+    memcpy(&buf[1], data, len < FEATURE_REPORT_SIZE ? len : FEATURE_REPORT_SIZE);
+    if (ioctl(fd, HIDIOCSFEATURE(sizeof(buf)), buf) < 0) {
+        perror("HIDIOCSFEATURE");
+        return false;
+    }
+    return true;
+}
+
+bool hidraw_get_feature(int fd, uint8_t report_id, void *data, size_t len) {
+    uint8_t buf[FEATURE_REPORT_SIZE + 1] = {report_id};
+    if (ioctl(fd, HIDIOCGFEATURE(sizeof(buf)), buf) < 0) {
+        perror("HIDIOCGFEATURE");
+        return false;
+    }
+    memcpy(data, &buf[1], len < FEATURE_REPORT_SIZE ? len : FEATURE_REPORT_SIZE);
+    return true;
+}
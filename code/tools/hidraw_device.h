@@ -0,0 +1,18 @@
+#ifndef _HIDRAW_DEVICE_H_
+#define _HIDRAW_DEVICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// See src/me.h.
+#define USB_VID 0xda1e
+#define USB_PID 0xB0CA
+
+// Feature reports are FEATURE_REPORT_SIZE bytes after the report ID.
+#define FEATURE_REPORT_SIZE 63
+
+int hidraw_open(const char *path);
+bool hidraw_set_feature(int fd, uint8_t report_id, const void *data, size_t len);
+bool hidraw_get_feature(int fd, uint8_t report_id, void *data, size_t len);
+
+#endif
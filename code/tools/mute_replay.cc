@@ -0,0 +1,119 @@
+// Replays a capture from mute_trace through a host build of the firmware and
+// compares the reports it delivers with the ones in the capture. Faults can
+// be injected on top; the reports then differ, but the host must still end
+// up agreeing with the device.
+//
+// Usage: mute_replay [-b gpio,count,at_ms,period_ms] [-k at_ms,for_ms]
+//                    [-s at_ms,for_ms] [-w replay.bin] capture.bin
+//   -b  burst of clean presses on a pin
+//   -k  host stops taking reports (busy endpoint)
+//   -s  bus suspend, then resume
+//   -w  write the trace recorded during the replay as a capture
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "replay.h"
+#include "trace_file.h"
+
+static bool parse_ms_pair(const char *arg, uint32_t *at_us, uint32_t *for_us) {
+    unsigned a, b;
+    if (sscanf(arg, "%u,%u", &a, &b) != 2) return false;
+    *at_us = a * 1000;
+    *for_us = b * 1000;
+    return true;
+}
+
+static bool parse_burst(const char *arg, replay_faults *f) {
+    unsigned gpio, count, at, period;
+    if (sscanf(arg, "%u,%u,%u,%u", &gpio, &count, &at, &period) != 4) return false;
+    f->burst_gpio = gpio;
+    f->burst_count = count;
+    f->burst_at_us = at * 1000;
+    f->burst_period_us = period * 1000;
+    return true;
+}
+
+/**
+ * @brief Prints one report per line, as id:value at its time in ms from the
+ * start of the capture, captured and replayed side by side.
+ */
+static void print_reports(const std::vector<trace_record> &expected, uint32_t expected_t0,
+                          const std::vector<trace_record> &got, uint32_t got_t0) {
+    printf("      captured            replayed\n");
+    for (size_t i = 0; i < std::max(expected.size(), got.size()); i++) {
+        if (i < expected.size()) {
+            const trace_record &r = expected[i];
+            printf("  %10.3f %u:%02x", (r.time_us - expected_t0) / 1000.0, r.arg, r.value);
+        } else {
+            printf("  %15s", "");
+        }
+        if (i < got.size()) {
+            const trace_record &r = got[i];
+            printf("   %10.3f %u:%02x", (r.time_us - got_t0) / 1000.0, r.arg, r.value);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    replay_faults faults = {};
+    bool faulty = false;
+    const char *write_path = nullptr;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:k:s:w:")) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'b': ok = parse_burst(optarg, &faults); break;
+            case 'k': ok = parse_ms_pair(optarg, &faults.busy_at_us, &faults.busy_for_us); break;
+            case 's': ok = parse_ms_pair(optarg, &faults.suspend_at_us, &faults.suspend_for_us); break;
+            case 'w': write_path = optarg; break;
+            default: ok = false; break;
+        }
+        if (!ok) {
+            fprintf(stderr, "Usage: %s [-b gpio,count,at_ms,period_ms] [-k at_ms,for_ms] [-s at_ms,for_ms] [-w replay.bin] capture.bin\n", argv[0]);
+            return 2;
+        }
+        faulty |= opt != 'w';
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "No capture file given\n");
+        return 2;
+    }
+
+    std::vector<trace_record> capture;
+    if (!read_capture(argv[optind], &capture)) return 1;
+
+    replay_result result;
+    replay_run(capture, faults, &result);
+    if (write_path && !write_capture(write_path, result.device)) return 1;
+
+    std::vector<trace_record> expected = replay_reports(capture);
+    std::vector<trace_record> got = replay_reports(result.device);
+    print_reports(expected, capture.empty() ? 0 : capture[0].time_us, got, REPLAY_START_US);
+
+    bool ok = true;
+    for (uint8_t id : { REPORT_ID_TELEPHONY, REPORT_ID_CONSUMER_CONTROL }) {
+        if (result.host_value[id] != result.final_value[id]) {
+            printf("report %u: host ended at 0x%02x, device at 0x%02x\n", id, result.host_value[id], result.final_value[id]);
+            ok = false;
+        }
+    }
+    if (expected.empty()) {
+        printf("capture has no reports to compare with\n");
+    } else if (!faulty) {
+        bool same = expected.size() == got.size() &&
+                    std::equal(expected.begin(), expected.end(), got.begin(), [](const trace_record &a, const trace_record &b) {
+                        return a.arg == b.arg && a.value == b.value;
+                    });
+        if (!same) {
+            printf("replayed reports differ from the capture\n");
+            ok = false;
+        }
+    }
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+// Reads the input trace ring of a mute button built with INPUT_TRACE into a
+// capture file, or prints a capture file. Also reads the report pipeline
+// counters, which every build has.
+//
+// Usage: mute_trace [-d /dev/hidrawN] capture.bin    read the ring into a file
+//        mute_trace [-d /dev/hidrawN] -c             clear the ring
+//        mute_trace [-d /dev/hidrawN] -s             print the report counters
+//        mute_trace -p capture.bin                   print a capture
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "input_trace_proto.h"
+#include "report_stats_proto.h"
+#include "hidraw_device.h"
+#include "trace_file.h"
+
+static_assert(TRACE_REPORT_SIZE == FEATURE_REPORT_SIZE, "Trace report size mismatch");
+static_assert(STATS_REPORT_SIZE == FEATURE_REPORT_SIZE, "Stats report size mismatch");
+
+static bool read_ring(int fd, std::vector<trace_record> *out) {
+    trace_chunk chunk;
+    do {
+        if (!hidraw_get_feature(fd, TRACE_REPORT_ID, &chunk, sizeof(chunk))) return false;
+        if (chunk.count > TRACE_RECORDS_PER_REPORT) {
+            fprintf(stderr, "Bad chunk\n");
+            return false;
+        }
+        out->insert(out->end(), chunk.records, chunk.records + chunk.count);
+    } while (chunk.count > 0);
+
+    if (chunk.dropped) fprintf(stderr, "Warning: %u records were overwritten before being read\n", chunk.dropped);
+    return true;
+}
+
+static const char *usb_event_name(uint8_t e) {
+    switch (e) {
+        case TRACE_USB_MOUNT: return "mount";
+        case TRACE_USB_UMOUNT: return "umount";
+        case TRACE_USB_SUSPEND: return "suspend";
+        case TRACE_USB_RESUME: return "resume";
+        default: return "?";
+    }
+}
+
+static const char *gpio_edge_name(uint16_t value) {
+    switch (value & (TRACE_GPIO_FELL | TRACE_GPIO_ROSE)) {
+        case TRACE_GPIO_FELL: return "fell";
+        case TRACE_GPIO_ROSE: return "rose";
+        default: return "fell and rose";
+    }
+}
+
+static void print_capture(const std::vector<trace_record> &records) {
+    if (records.empty()) return;
+
+    // Timestamps are 32-bit microseconds; unsigned subtraction handles the wrap.
+    uint64_t t = 0;
+    uint32_t prev = records[0].time_us;
+    uint32_t armed_us[256] = {};
+    for (const trace_record &r : records) {
+        t += (uint32_t)(r.time_us - prev);
+        prev = r.time_us;
+        printf("%10.3f ms  ", t / 1000.0);
+        switch (r.type) {
+            case TRACE_GPIO:
+                printf("gpio     %u %s, now %s\n", r.arg, gpio_edge_name(r.value),
+                       r.value & TRACE_GPIO_LEVEL ? "high" : "low");
+                break;
+            case TRACE_ENCODER:
+                printf("encoder  position %d\n", (int16_t)r.value);
+                break;
+            case TRACE_SET_REPORT:
+                printf("host     set report %u: 0x%02x\n", r.arg, r.value);
+                break;
+            case TRACE_USB:
+                printf("usb      %s\n", usb_event_name(r.arg));
+                break;
+            case TRACE_ARM:
+                printf("device   armed report %u, %u us into the frame\n", r.arg, r.value);
+                armed_us[r.arg] = r.time_us;
+                break;
+            case TRACE_REPORT:
+                printf("device   report %u: 0x%02x  %.3f ms after arming\n", r.arg, r.value,
+                       (uint32_t)(r.time_us - armed_us[r.arg]) / 1000.0);
+                break;
+            default:
+                printf("unknown  type %u arg %u value 0x%04x\n", r.type, r.arg, r.value);
+                break;
+        }
+    }
+}
+
+static bool print_stats(int fd) {
+    report_stats st;
+    if (!hidraw_get_feature(fd, STATS_REPORT_ID, &st, sizeof(st))) return false;
+    printf("delivered %u, retried %u\n", st.delivered, st.retried);
+    if (st.delivered) {
+        printf("latency from arming to completion: max %.3f ms, average %.3f ms\n", st.latency_us_max / 1000.0,
+               st.latency_us_total / 1000.0 / st.delivered);
+    }
+    printf("armed at, us into the frame:\n");
+    const unsigned width = 1000 / STATS_OFFSET_BUCKETS;
+    for (unsigned i = 0; i < STATS_OFFSET_BUCKETS; i++) {
+        printf("  %4u-%4u  %u\n", i * width, (i + 1) * width - 1, st.arm_offset[i]);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *dev = nullptr;
+    bool clear = false;
+    bool print = false;
+    bool stats = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:cps")) != -1) {
+        switch (opt) {
+            case 'd': dev = optarg; break;
+            case 'c': clear = true; break;
+            case 'p': print = true; break;
+            case 's': stats = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-d /dev/hidrawN] capture.bin | -c | -s | -p capture.bin\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (!clear && !stats && optind >= argc) {
+        fprintf(stderr, "No capture file given\n");
+        return 2;
+    }
+
+    std::vector<trace_record> records;
+
+    if (print) {
+        if (!read_capture(argv[optind], &records)) return 1;
+        print_capture(records);
+        return 0;
+    }
+
+    int fd = hidraw_open(dev);
+    if (fd < 0) {
+        perror(dev ? dev : "No mute button found");
+        return 1;
+    }
+
+    if (stats) {
+        bool ok = print_stats(fd);
+        close(fd);
+        return ok ? 0 : 1;
+    }
+
+    if (clear) {
+        uint8_t cmd = TRACE_CMD_CLEAR;
+        bool ok = hidraw_set_feature(fd, TRACE_REPORT_ID, &cmd, 1);
+        close(fd);
+        return ok ? 0 : 1;
+    }
+
+    bool ok = read_ring(fd, &records) && write_capture(argv[optind], records);
+    close(fd);
+    if (ok) printf("%zu records written to %s\n", records.size(), argv[optind]);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+// Host side of the in-band firmware update. Streams a .bin image into the
+// staging slot of a mute button over its HID feature report. Images are
+// linked for one slot, so pass both builds of the firmware; the one for the
+// slot the device is not running from is sent.
+//
+// Usage: mute_update [-d /dev/hidrawN] [-n] mute_button.bin mute_button_b.bin
+//        mute_update [-d /dev/hidrawN] -s
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "fw_update_proto.h"
+#include "hidraw_device.h"
+
+#define POLL_INTERVAL_US 1000
+#define POLL_TIMEOUT_MS 5000
+
+static_assert(FW_UPDATE_REPORT_SIZE == FEATURE_REPORT_SIZE, "Update report size mismatch");
+
+static bool send(int fd, const void *cmd, size_t len) {
+    return hidraw_set_feature(fd, FW_UPDATE_REPORT_ID, cmd, len);
+}
+
+static bool get_status(int fd, fw_status *st) {
+    return hidraw_get_feature(fd, FW_UPDATE_REPORT_ID, st, sizeof(*st));
+}
+
+static const char *state_name(uint8_t s) {
+    switch (s) {
+        case FW_STATE_IDLE: return "idle";
+        case FW_STATE_RECEIVING: return "receiving";
+        case FW_STATE_VERIFYING: return "verifying";
+        case FW_STATE_READY: return "ready";
+        case FW_STATE_ERROR: return "error";
+        default: return "?";
+    }
+}
+
+static const char *error_name(uint8_t e) {
+    switch (e) {
+        case FW_ERR_NONE: return "none";
+        case FW_ERR_TOO_BIG: return "image too big";
+        case FW_ERR_SEQUENCE: return "out of sequence";
+        case FW_ERR_BUSY: return "busy";
+        case FW_ERR_CRC: return "CRC mismatch";
+        case FW_ERR_STATE: return "wrong state";
+        case FW_ERR_COMMAND: return "bad command";
+        case FW_ERR_IMAGE: return "image not built for the staging slot";
+        case FW_ERR_BOARD: return "image built for another board";
+        default: return "?";
+    }
+}
+
+static const char *boot_name(uint8_t b) {
+    switch (b) {
+        case FW_BOOT_NONE: return "none";
+        case FW_BOOT_TRIAL: return "trial";
+        case FW_BOOT_CONFIRMED: return "confirmed";
+        case FW_BOOT_REVERTED: return "reverted";
+        case FW_BOOT_BAD_IMAGE: return "bad image";
+        default: return "?";
+    }
+}
+
+static void print_status(const fw_status &st) {
+    char version[sizeof(st.version) + 1] = {};
+    memcpy(version, st.version, sizeof(st.version));
+    printf("version %s, board 0x%02x, state %s, error %s, last switch %s, %u/%u bytes written, next image goes to slot %c\n",
+           version, st.board, state_name(st.state), error_name(st.error), boot_name(st.boot_result),
+           st.written, st.size, 'A' + st.staging_slot);
+}
+
+/**
+ * @brief Polls the device until done() holds or it reports an error.
+ */
+template <typename Pred>
+static bool wait_for(int fd, fw_status *st, Pred done) {
+    for (int waited_us = 0; waited_us < POLL_TIMEOUT_MS * 1000; waited_us += POLL_INTERVAL_US) {
+        if (!get_status(fd, st)) return false;
+        if (st->error != FW_ERR_NONE || st->state == FW_STATE_ERROR) {
+            fprintf(stderr, "Device error: %s\n", error_name(st->error));
+            return false;
+        }
+        if (done(*st)) return true;
+        usleep(POLL_INTERVAL_US);
+    }
+    fprintf(stderr, "Timed out waiting for the device\n");
+    return false;
+}
+
+static bool update(int fd, const std::vector<uint8_t> &image, bool reboot) {
+    fw_status st;
+
+    fw_cmd_begin begin = {FW_CMD_BEGIN, (uint32_t)image.size(), fw_crc32(0, image.data(), image.size())};
+    if (!send(fd, &begin, sizeof(begin))) return false;
+    if (!wait_for(fd, &st, [](const fw_status &s) { return s.state == FW_STATE_RECEIVING; })) return false;
+
+    for (uint32_t offs = 0; offs < image.size(); offs += FW_UPDATE_CHUNK_SIZE) {
+        fw_cmd_data data = {};
+        data.cmd = FW_CMD_DATA;
+        data.offset = offs;
+        data.len = image.size() - offs < FW_UPDATE_CHUNK_SIZE ? image.size() - offs : FW_UPDATE_CHUNK_SIZE;
+        memcpy(data.data, &image[offs], data.len);
+        if (!send(fd, &data, sizeof(data))) return false;
+
+        // The device holds a single page; let it reach flash before sending more.
+        uint32_t end = offs + data.len;
+        if (end % FW_UPDATE_PAGE_SIZE == 0 || end == image.size()) {
+            if (!wait_for(fd, &st, [end](const fw_status &s) { return s.written >= end; })) return false;
+            printf("\r%u/%zu", end, image.size());
+            fflush(stdout);
+        }
+    }
+    printf("\n");
+
+    uint8_t cmd = FW_CMD_COMMIT;
+    if (!send(fd, &cmd, 1)) return false;
+    if (!wait_for(fd, &st, [](const fw_status &s) { return s.state == FW_STATE_READY; })) return false;
+    printf("Image verified, the loader switches slots on next reset\n");
+
+    if (reboot) {
+        cmd = FW_CMD_REBOOT;
+        if (!send(fd, &cmd, 1)) return false;
+        printf("Rebooting. The new image must mount within %d ms or the previous one is restored;\n"
+               "run with -s afterwards to see the outcome.\n", FW_TRIAL_TIMEOUT_MS);
+    }
+    return true;
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> *out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out->insert(out->end(), buf, buf + n);
+    fclose(f);
+    return !out->empty();
+}
+
+/**
+ * @brief Picks the image linked for the given slot out of the ones given.
+ * Refuses images built for another board than the device's.
+ */
+static bool pick_image(char **paths, int count, uint8_t slot, uint8_t board, std::vector<uint8_t> *out) {
+    for (int i = 0; i < count; i++) {
+        std::vector<uint8_t> image;
+        if (!read_file(paths[i], &image)) return false;
+        const fw_image_info *info = fw_image_find_info(image.data(), image.size());
+        if (!info) {
+            fprintf(stderr, "%s: not a mute button image\n", paths[i]);
+            return false;
+        }
+        if (info->board != board) {
+            fprintf(stderr, "%s: built for board 0x%02x, the device is board 0x%02x\n", paths[i], info->board, board);
+            return false;
+        }
+        if (info->slot == slot) {
+            printf("Sending %s\n", paths[i]);
+            *out = std::move(image);
+            return true;
+        }
+    }
+    fprintf(stderr, "None of the images is built for slot %c\n", 'A' + slot);
+    return false;
+}
+
+int main(int argc, char **argv) {
+    const char *dev = nullptr;
+    bool status_only = false;
+    bool reboot = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:sn")) != -1) {
+        switch (opt) {
+            case 'd': dev = optarg; break;
+            case 's': status_only = true; break;
+            case 'n': reboot = false; break;
+            default:
+                fprintf(stderr, "Usage: %s [-d /dev/hidrawN] [-n] image.bin image_b.bin | -s\n", argv[0]);
+                return 2;
+        }
+    }
+
+    int fd = hidraw_open(dev);
+    if (fd < 0) {
+        perror(dev ? dev : "No mute button found");
+        return 1;
+    }
+
+    fw_status st = {};
+    if (!get_status(fd, &st)) return 1;
+    print_status(st);
+    if (status_only) return 0;
+
+    if (optind >= argc) {
+        fprintf(stderr, "No image given\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> image;
+    if (!pick_image(&argv[optind], argc - optind, st.staging_slot, st.board, &image)) return 1;
+
+    bool ok = update(fd, image, reboot);
+    close(fd);
+    return ok ? 0 : 1;
+}
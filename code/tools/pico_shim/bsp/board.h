@@ -0,0 +1,13 @@
+#ifndef _SHIM_BSP_BOARD_H_
+#define _SHIM_BSP_BOARD_H_
+
+#include "pico/time.h"
+
+static inline void board_init() {
+}
+
+static inline uint32_t board_millis() {
+    return static_cast<uint32_t>(time_us_64() / 1000);
+}
+
+#endif
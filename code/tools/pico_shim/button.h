@@ -0,0 +1,22 @@
+#ifndef _SHIM_BUTTON_H_
+#define _SHIM_BUTTON_H_
+
+// Stand-in for the RP2040-Button library. Debounces the way the library
+// does, settle then report: every edge restarts a timer, and the pin is
+// only read and reported once it has been quiet for SHIM_BUTTON_SETTLE_US.
+
+#include "hardware/gpio.h"
+
+#ifndef SHIM_BUTTON_SETTLE_US
+#define SHIM_BUTTON_SETTLE_US 10000
+#endif
+
+typedef struct button_t {
+    uint8_t pin;
+    bool state;
+    void (*onchange)(struct button_t *button_p);
+} button_t;
+
+button_t *create_button(int pin, void (*onchange)(button_t *));
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _SHIM_CLASS_HID_HID_DEVICE_H_
+#define _SHIM_CLASS_HID_HID_DEVICE_H_
+
+#include "pico_shim.h"
+
+typedef enum {
+    HID_REPORT_TYPE_INVALID = 0,
+    HID_REPORT_TYPE_INPUT,
+    HID_REPORT_TYPE_OUTPUT,
+    HID_REPORT_TYPE_FEATURE,
+} hid_report_type_t;
+
+enum {
+    HID_SUBCLASS_BOOT = 1,
+    HID_ITF_PROTOCOL_NONE = 0,
+    HID_DESC_TYPE_HID = 0x21,
+    HID_DESC_TYPE_REPORT = 0x22,
+};
+
+enum {
+    HID_USAGE_CONSUMER_VOLUME_INCREMENT = 0x00E9,
+    HID_USAGE_CONSUMER_VOLUME_DECREMENT = 0x00EA,
+};
+
+bool tud_hid_ready();
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len);
+
+// Implemented by the firmware; weak as in tinyusb.
+__attribute__((weak)) void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize);
+__attribute__((weak)) uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen);
+__attribute__((weak)) void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _SHIM_ENCODER_H_
+#define _SHIM_ENCODER_H_
+
+// Stand-in for the RP2040-Rotary-Encoder library. Quadrature decoding is
+// not simulated; tests move the encoder with shim_encoder_set_position().
+
+#include "pico_shim.h"
+
+typedef struct rotary_encoder_t {
+    uint8_t pin_a;
+    uint8_t pin_b;
+    uint8_t state;
+    long int position;
+    void (*onchange)(struct rotary_encoder_t *encoder);
+} rotary_encoder_t;
+
+rotary_encoder_t *create_encoder(uint8_t pin_a, uint8_t pin_b, void (*onchange)(rotary_encoder_t *));
+
+/**
+ * @brief Moves the encoder created last and calls its onchange from
+ * interrupt context, as the library does.
+ */
+void shim_encoder_set_position(long int position);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _SHIM_HARDWARE_ADDRESS_MAPPED_H_
+#define _SHIM_HARDWARE_ADDRESS_MAPPED_H_
+
+#include "pico_shim.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+
+static inline void hw_set_bits(io_rw_32 *addr, uint32_t mask) {
+    *addr |= mask;
+}
+
+static inline void hw_clear_bits(io_rw_32 *addr, uint32_t mask) {
+    *addr &= ~mask;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _SHIM_HARDWARE_CLOCKS_H_
+#define _SHIM_HARDWARE_CLOCKS_H_
+
+#include "pico_shim.h"
+
+#ifndef SYS_CLK_KHZ
+#define SYS_CLK_KHZ 125000
+#endif
+
+enum clock_index {
+    clk_sys = 5,
+    clk_peri = 6,
+};
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+void set_sys_clock_48mhz();
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _SHIM_HARDWARE_GPIO_H_
+#define _SHIM_HARDWARE_GPIO_H_
+
+#include "hardware/irq.h"
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(unsigned gpio, uint32_t event_mask);
+
+void gpio_init(unsigned gpio);
+void gpio_set_dir(unsigned gpio, bool out);
+void gpio_pull_up(unsigned gpio);
+bool gpio_get(unsigned gpio);
+uint32_t gpio_get_all();
+
+void gpio_set_irq_enabled(unsigned gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(unsigned gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+uint32_t gpio_get_irq_event_mask(unsigned gpio);
+void gpio_acknowledge_irq(unsigned gpio, uint32_t event_mask);
+void gpio_add_raw_irq_handler_with_order_priority_masked(uint32_t gpio_mask, irq_handler_t handler, uint8_t order_priority);
+
+static inline void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler) {
+    gpio_add_raw_irq_handler_with_order_priority_masked(gpio_mask, handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef _SHIM_HARDWARE_IRQ_H_
+#define _SHIM_HARDWARE_IRQ_H_
+
+#include "hardware/sync.h"
+
+#define IO_IRQ_BANK0 13
+
+// Shared handlers with a higher order priority run first.
+#define PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY 0xff
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+#define PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY 0x00
+
+typedef void (*irq_handler_t)();
+
+void irq_set_enabled(unsigned num, bool enabled);
+
+#endif
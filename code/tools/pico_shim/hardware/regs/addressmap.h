@@ -0,0 +1,12 @@
+#ifndef _SHIM_HARDWARE_REGS_ADDRESSMAP_H_
+#define _SHIM_HARDWARE_REGS_ADDRESSMAP_H_
+
+#include "pico_shim.h"
+
+// Flash reads go to the simulated flash. SRAM is only ever compared against,
+// so it keeps its real addresses.
+#define XIP_BASE (reinterpret_cast<uintptr_t>(shim_flash))
+#define SRAM_BASE 0x20000000u
+#define SRAM_END 0x20042000u
+
+#endif
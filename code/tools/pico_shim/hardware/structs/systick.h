@@ -0,0 +1,15 @@
+#ifndef _SHIM_HARDWARE_STRUCTS_SYSTICK_H_
+#define _SHIM_HARDWARE_STRUCTS_SYSTICK_H_
+
+#include "hardware/address_mapped.h"
+
+typedef struct {
+    io_rw_32 csr;
+    io_rw_32 rvr;
+    io_rw_32 cvr;
+    io_rw_32 calib;
+} systick_hw_t;
+
+extern systick_hw_t *const systick_hw;
+
+#endif
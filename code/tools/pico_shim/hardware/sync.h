@@ -0,0 +1,9 @@
+#ifndef _SHIM_HARDWARE_SYNC_H_
+#define _SHIM_HARDWARE_SYNC_H_
+
+#include "pico_shim.h"
+
+uint32_t save_and_disable_interrupts();
+void restore_interrupts(uint32_t status);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef _SHIM_HARDWARE_TIMER_H_
+#define _SHIM_HARDWARE_TIMER_H_
+
+#include "pico/time.h"
+
+#endif
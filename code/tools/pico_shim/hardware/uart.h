@@ -0,0 +1,6 @@
+#ifndef _SHIM_HARDWARE_UART_H_
+#define _SHIM_HARDWARE_UART_H_
+
+#include "pico_shim.h"
+
+#endif
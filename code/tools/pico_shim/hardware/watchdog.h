@@ -0,0 +1,19 @@
+#ifndef _SHIM_HARDWARE_WATCHDOG_H_
+#define _SHIM_HARDWARE_WATCHDOG_H_
+
+#include "hardware/address_mapped.h"
+
+#define WATCHDOG_CTRL_ENABLE_BITS 0x40000000u
+
+typedef struct {
+    io_rw_32 ctrl;
+    io_rw_32 load;
+} watchdog_hw_t;
+
+extern watchdog_hw_t *const watchdog_hw;
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update();
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms);
+
+#endif
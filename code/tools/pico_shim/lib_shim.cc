@@ -0,0 +1,57 @@
+#include <button.h>
+#include <encoder.h>
+#include <pico/time.h>
+
+// Stand-ins for the RP2040-Button and RP2040-Rotary-Encoder libraries.
+
+#define SHIM_MAX_BUTTONS 8
+
+struct shim_button {
+    button_t button;
+    alarm_id_t settle;
+};
+
+static shim_button buttons[SHIM_MAX_BUTTONS];
+static uint8_t button_count = 0;
+static rotary_encoder_t encoder;
+
+static int64_t button_settled(alarm_id_t, void *user_data) {
+    shim_button *b = static_cast<shim_button *>(user_data);
+    b->settle = 0;
+    bool level = gpio_get(b->button.pin);
+    if (level != b->button.state) {
+        b->button.state = level;
+        b->button.onchange(&b->button);
+    }
+    return 0;
+}
+
+static void button_irq(unsigned gpio, uint32_t) {
+    for (uint8_t i = 0; i < button_count; i++) {
+        shim_button *b = &buttons[i];
+        if (b->button.pin != gpio) continue;
+        if (b->settle) cancel_alarm(b->settle);
+        b->settle = add_alarm_in_us(SHIM_BUTTON_SETTLE_US, button_settled, b, true);
+    }
+}
+
+button_t *create_button(int pin, void (*onchange)(button_t *)) {
+    if (button_count >= SHIM_MAX_BUTTONS) return nullptr;
+    shim_button *b = &buttons[button_count++];
+    gpio_init(pin);
+    gpio_pull_up(pin);
+    b->button = { static_cast<uint8_t>(pin), gpio_get(pin), onchange };
+    b->settle = 0;
+    gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, button_irq);
+    return &b->button;
+}
+
+rotary_encoder_t *create_encoder(uint8_t pin_a, uint8_t pin_b, void (*onchange)(rotary_encoder_t *)) {
+    encoder = { pin_a, pin_b, 0, 0, onchange };
+    return &encoder;
+}
+
+void shim_encoder_set_position(long int position) {
+    encoder.position = position;
+    if (encoder.onchange) encoder.onchange(&encoder);
+}
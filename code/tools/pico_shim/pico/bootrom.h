@@ -0,0 +1,9 @@
+#ifndef _SHIM_PICO_BOOTROM_H_
+#define _SHIM_PICO_BOOTROM_H_
+
+#include "pico_shim.h"
+
+// Returns, unlike on the device; see shim_usb_boot_requested().
+void reset_usb_boot(uint32_t gpio_activity_pin_mask, uint32_t disable_interface_mask);
+
+#endif
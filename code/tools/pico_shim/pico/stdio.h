@@ -0,0 +1,12 @@
+#ifndef _SHIM_PICO_STDIO_H_
+#define _SHIM_PICO_STDIO_H_
+
+#include <stdio.h>
+
+#include "pico_shim.h"
+
+static inline bool stdio_init_all() {
+    return true;
+}
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef _SHIM_PICO_STDLIB_H_
+#define _SHIM_PICO_STDLIB_H_
+
+#include "hardware/gpio.h"
+#include "pico/time.h"
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _SHIM_PICO_UNIQUE_ID_H_
+#define _SHIM_PICO_UNIQUE_ID_H_
+
+#include "pico_shim.h"
+
+#define PICO_UNIQUE_BOARD_ID_SIZE_BYTES 8
+
+void pico_get_unique_board_id_string(char *id_out, unsigned len);
+
+#endif
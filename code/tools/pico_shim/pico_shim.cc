@@ -0,0 +1,405 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <hardware/clocks.h>
+#include <hardware/flash.h>
+#include <hardware/gpio.h>
+#include <hardware/structs/systick.h>
+#include <hardware/sync.h>
+#include <hardware/watchdog.h>
+#include <pico/bootrom.h>
+#include <pico/time.h>
+#include <pico/unique_id.h>
+
+#include "pico_shim.h"
+#include "tusb_shim.h"
+
+uint8_t shim_flash[PICO_FLASH_SIZE_BYTES];
+
+static watchdog_hw_t watchdog_regs;
+watchdog_hw_t *const watchdog_hw = &watchdog_regs;
+
+static systick_hw_t systick_regs;
+systick_hw_t *const systick_hw = &systick_regs;
+
+static uint64_t now_us = 0;
+static uint64_t next_frame_us = 1000;
+static int flash_ops_left = -1;
+static size_t flash_cut_at = 0;
+static uint32_t erase_count = 0;
+static uint32_t program_count = 0;
+static bool reboot_requested = false;
+static bool usb_boot_requested = false;
+static uint32_t sys_khz = SYS_CLK_KHZ;
+static uint32_t relock_us = 0;
+
+struct raw_handler {
+    irq_handler_t handler;
+    uint8_t priority;
+};
+
+static uint32_t gpio_levels = 0;
+static uint32_t gpio_irq_enabled[SHIM_NUM_GPIOS];
+static uint32_t gpio_irq_events[SHIM_NUM_GPIOS];
+static std::vector<raw_handler> raw_handlers;
+static uint32_t raw_irq_mask = 0;
+static gpio_irq_callback_t gpio_callback = nullptr;
+static bool bank0_enabled = false;
+static uint32_t irq_disable_depth = 0;
+static bool irq_pending = false;
+static bool in_irq = false;
+
+struct alarm {
+    alarm_id_t id;
+    uint64_t at;
+    alarm_callback_t callback;
+    void *user_data;
+};
+
+static std::vector<alarm> alarms;
+static alarm_id_t next_alarm_id = 1;
+
+static void dispatch_gpio_irq();
+
+void shim_reset() {
+    memset(shim_flash, 0xff, sizeof(shim_flash));
+    watchdog_regs = {};
+    now_us = 0;
+    next_frame_us = 1000;
+    flash_ops_left = -1;
+    flash_cut_at = 0;
+    erase_count = 0;
+    program_count = 0;
+    reboot_requested = false;
+    usb_boot_requested = false;
+    sys_khz = SYS_CLK_KHZ;
+    relock_us = 0;
+
+    gpio_levels = (1u << SHIM_NUM_GPIOS) - 1;
+    memset(gpio_irq_enabled, 0, sizeof(gpio_irq_enabled));
+    memset(gpio_irq_events, 0, sizeof(gpio_irq_events));
+    raw_handlers.clear();
+    raw_irq_mask = 0;
+    gpio_callback = nullptr;
+    bank0_enabled = false;
+    irq_disable_depth = 0;
+    irq_pending = false;
+    in_irq = false;
+
+    alarms.clear();
+    next_alarm_id = 1;
+
+    shim_usb_reset();
+}
+
+void shim_flash_fail_after(int n, size_t done) {
+    flash_ops_left = n;
+    flash_cut_at = done;
+}
+
+uint32_t shim_flash_erase_count() {
+    return erase_count;
+}
+
+uint32_t shim_flash_program_count() {
+    return program_count;
+}
+
+/**
+ * @brief Counts down the fault budget.
+ *
+ * @return true if this operation is the one the power cut hits.
+ */
+static bool power_cut_now() {
+    if (flash_ops_left < 0) return false;
+    return flash_ops_left-- == 0;
+}
+
+//--------------------------------------------------------------------+
+// hardware/flash.h
+//--------------------------------------------------------------------+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_erase: bad range 0x%x+0x%zx\n", flash_offs, count);
+        abort();
+    }
+    erase_count++;
+    if (power_cut_now()) {
+        memset(&shim_flash[flash_offs], 0xff, std::min(flash_cut_at, count));
+        throw shim_power_cut();
+    }
+    memset(&shim_flash[flash_offs], 0xff, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_program: bad range 0x%x+0x%zx\n", flash_offs, count);
+        abort();
+    }
+    program_count++;
+    // NOR flash only clears bits; programming over unerased data corrupts it.
+    size_t n = power_cut_now() ? std::min(flash_cut_at, count) : count;
+    for (size_t i = 0; i < n; i++) shim_flash[flash_offs + i] &= data[i];
+    if (n != count) throw shim_power_cut();
+}
+
+//--------------------------------------------------------------------+
+// hardware/sync.h
+//--------------------------------------------------------------------+
+uint32_t save_and_disable_interrupts() {
+    return irq_disable_depth++;
+}
+
+void restore_interrupts(uint32_t status) {
+    irq_disable_depth = status;
+    if (irq_disable_depth == 0 && irq_pending) dispatch_gpio_irq();
+}
+
+//--------------------------------------------------------------------+
+// hardware/gpio.h, hardware/irq.h
+//--------------------------------------------------------------------+
+void gpio_init(unsigned gpio) {
+    gpio_irq_enabled[gpio] = 0;
+    gpio_irq_events[gpio] = 0;
+}
+
+void gpio_set_dir(unsigned, bool) {
+}
+
+void gpio_pull_up(unsigned) {
+}
+
+bool gpio_get(unsigned gpio) {
+    return gpio_levels & (1u << gpio);
+}
+
+uint32_t gpio_get_all() {
+    return gpio_levels;
+}
+
+void gpio_set_irq_enabled(unsigned gpio, uint32_t event_mask, bool enabled) {
+    if (enabled) gpio_irq_enabled[gpio] |= event_mask;
+    else gpio_irq_enabled[gpio] &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    gpio_callback = callback;
+    bank0_enabled = true;
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned gpio) {
+    return gpio_irq_events[gpio];
+}
+
+void gpio_acknowledge_irq(unsigned gpio, uint32_t event_mask) {
+    gpio_irq_events[gpio] &= ~event_mask;
+}
+
+// Like the SDK, each pin can have one raw handler, and the callback no longer
+// sees the pins a raw handler took.
+void gpio_add_raw_irq_handler_with_order_priority_masked(uint32_t gpio_mask, irq_handler_t handler, uint8_t order_priority) {
+    if (raw_irq_mask & gpio_mask) {
+        fprintf(stderr, "gpio_add_raw_irq_handler: pins 0x%x already have a raw handler\n", raw_irq_mask & gpio_mask);
+        abort();
+    }
+    raw_irq_mask |= gpio_mask;
+    raw_handler h = { handler, order_priority };
+    auto pos = std::find_if(raw_handlers.begin(), raw_handlers.end(),
+                            [&](const raw_handler &o) { return o.priority < order_priority; });
+    raw_handlers.insert(pos, h);
+}
+
+void irq_set_enabled(unsigned num, bool enabled) {
+    if (num == IO_IRQ_BANK0) bank0_enabled = enabled;
+}
+
+/**
+ * @brief Runs the bank 0 handlers the way the shared IRQ does: raw handlers
+ * by order priority, then the callback for every pin not taken by a raw
+ * handler that shows events.
+ */
+static void dispatch_gpio_irq() {
+    if (irq_disable_depth > 0 || in_irq) {
+        irq_pending = true;
+        return;
+    }
+    irq_pending = false;
+    in_irq = true;
+    for (const raw_handler &h : raw_handlers) h.handler();
+    if (gpio_callback) {
+        for (unsigned pin = 0; pin < SHIM_NUM_GPIOS; pin++) {
+            uint32_t events = gpio_irq_events[pin];
+            if (!events || (raw_irq_mask & (1u << pin))) continue;
+            gpio_acknowledge_irq(pin, events);
+            gpio_callback(pin, events);
+        }
+    }
+    in_irq = false;
+}
+
+void shim_gpio_set(uint8_t pin, bool level) {
+    uint32_t bit = 1u << pin;
+    if (level == !!(gpio_levels & bit)) return;
+    gpio_levels = level ? gpio_levels | bit : gpio_levels & ~bit;
+
+    uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (!(gpio_irq_enabled[pin] & edge)) return;
+    gpio_irq_events[pin] |= edge;
+    if (bank0_enabled) dispatch_gpio_irq();
+}
+
+//--------------------------------------------------------------------+
+// hardware/watchdog.h
+//--------------------------------------------------------------------+
+void watchdog_enable(uint32_t delay_ms, bool) {
+    watchdog_regs.load = delay_ms * 1000;
+    watchdog_regs.ctrl |= WATCHDOG_CTRL_ENABLE_BITS;
+}
+
+void watchdog_update() {
+}
+
+void watchdog_reboot(uint32_t, uint32_t, uint32_t) {
+    reboot_requested = true;
+}
+
+bool shim_watchdog_enabled() {
+    return watchdog_regs.ctrl & WATCHDOG_CTRL_ENABLE_BITS;
+}
+
+bool shim_reboot_requested() {
+    return reboot_requested;
+}
+
+//--------------------------------------------------------------------+
+// pico/bootrom.h
+//--------------------------------------------------------------------+
+void reset_usb_boot(uint32_t, uint32_t) {
+    usb_boot_requested = true;
+}
+
+bool shim_usb_boot_requested() {
+    return usb_boot_requested;
+}
+
+//--------------------------------------------------------------------+
+// hardware/clocks.h
+//--------------------------------------------------------------------+
+bool set_sys_clock_khz(uint32_t freq_khz, bool) {
+    busy_wait_us(relock_us);
+    sys_khz = freq_khz;
+    return true;
+}
+
+void set_sys_clock_48mhz() {
+    sys_khz = 48000;
+}
+
+uint32_t clock_get_hz(enum clock_index) {
+    return sys_khz * 1000;
+}
+
+void shim_clock_set_relock_us(uint32_t us) {
+    relock_us = us;
+}
+
+uint32_t shim_clock_khz() {
+    return sys_khz;
+}
+
+//--------------------------------------------------------------------+
+// pico/time.h
+//--------------------------------------------------------------------+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool) {
+    alarm a = { next_alarm_id++, now_us + us, callback, user_data };
+    alarms.push_back(a);
+    return a.id;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    auto it = std::find_if(alarms.begin(), alarms.end(), [&](const alarm &a) { return a.id == id; });
+    if (it == alarms.end()) return false;
+    alarms.erase(it);
+    return true;
+}
+
+/**
+ * @brief Fires the earliest alarm due at or before t, if there is one.
+ */
+static bool fire_next_alarm(uint64_t t) {
+    auto it = std::min_element(alarms.begin(), alarms.end(),
+                               [](const alarm &a, const alarm &b) { return a.at < b.at || (a.at == b.at && a.id < b.id); });
+    if (it == alarms.end() || it->at > t) return false;
+
+    alarm a = *it;
+    alarms.erase(it);
+    now_us = std::max(now_us, a.at);
+    int64_t again = a.callback(a.id, a.user_data);
+    if (again != 0) {
+        a.at = again > 0 ? a.at + again : now_us - again;
+        alarms.push_back(a);
+    }
+    return true;
+}
+
+/**
+ * @brief Advances time to t, firing alarms and starting a USB frame every
+ * millisecond. Alarms due at a frame boundary fire before the frame starts.
+ */
+void shim_time_run_until(uint64_t t) {
+    for (;;) {
+        uint64_t next = std::min(next_frame_us, t);
+        if (fire_next_alarm(next)) continue;
+        now_us = std::max(now_us, next);
+        if (now_us == next_frame_us) {
+            next_frame_us += 1000;
+            shim_usb_frame_tick();
+            continue;
+        }
+        if (now_us >= t) return;
+    }
+}
+
+void shim_time_advance_us(uint64_t us) {
+    shim_time_run_until(now_us + us);
+}
+
+uint64_t shim_time_us() {
+    return now_us;
+}
+
+absolute_time_t get_absolute_time() {
+    return now_us;
+}
+
+uint32_t time_us_32() {
+    return static_cast<uint32_t>(now_us);
+}
+
+uint64_t time_us_64() {
+    return now_us;
+}
+
+void busy_wait_us(uint64_t us) {
+    shim_time_advance_us(us);
+}
+
+void sleep_us(uint64_t us) {
+    shim_time_advance_us(us);
+}
+
+void sleep_ms(uint32_t ms) {
+    shim_time_advance_us(ms * 1000ull);
+}
+
+//--------------------------------------------------------------------+
+// pico/unique_id.h
+//--------------------------------------------------------------------+
+void pico_get_unique_board_id_string(char *id_out, unsigned len) {
+    snprintf(id_out, len, "E66038B713482A2F");
+}
@@ -0,0 +1,80 @@
+#ifndef _PICO_SHIM_H_
+#define _PICO_SHIM_H_
+
+// Host stand-ins for the parts of the pico-sdk, tinyusb and the button and
+// encoder libraries the firmware sources use, so they can be built and
+// driven natively by the tests and tools in tools/. Only what the firmware
+// actually calls is here; the headers under pico_shim/ mirror the real
+// include paths so the sources build unchanged.
+//
+// Besides the SDK calls, this header has the controls used to move time
+// forward, drive pins, look at flash and inject faults. USB has its own
+// controls in tusb_shim.h.
+//
+// Interrupts are simulated: a GPIO edge or an alarm that comes due runs its
+// handlers on the spot, unless interrupts are disabled, in which case they
+// run once they are enabled again. Time only moves when a test advances it,
+// or when the firmware sleeps or busy-waits.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+#define SHIM_NUM_GPIOS 30
+
+// From pico/types.h, which every SDK header pulls in.
+typedef unsigned int uint;
+
+// Backing store of the simulated flash, mapped where XIP_BASE points.
+extern uint8_t shim_flash[PICO_FLASH_SIZE_BYTES];
+
+/**
+ * @brief Thrown by flash writes once the budget set by shim_flash_fail_after()
+ * runs out, leaving the operation half done the way a power cut would.
+ */
+struct shim_power_cut {};
+
+/**
+ * @brief Puts the simulated chip in its power-on state: flash erased, time
+ * at zero, all pins pulled high, no interrupt handlers, no faults armed.
+ */
+void shim_reset();
+
+/**
+ * @brief Cuts power during the n-th flash erase or program from now, -1 to
+ * disarm. The operation gets through its first `done` bytes, then
+ * shim_power_cut is thrown.
+ */
+void shim_flash_fail_after(int n, size_t done = 0);
+
+uint32_t shim_flash_erase_count();
+uint32_t shim_flash_program_count();
+
+/**
+ * @brief Moves time forward, firing alarms and USB frames as they come due.
+ */
+void shim_time_advance_us(uint64_t us);
+void shim_time_run_until(uint64_t t);
+uint64_t shim_time_us();
+
+/**
+ * @brief Drives the level seen on a pin, as a switch or the host side of a
+ * wire would. Edges latch GPIO interrupt events like the hardware does.
+ */
+void shim_gpio_set(uint8_t pin, bool level);
+
+/**
+ * @brief Time it takes the system PLL to relock in set_sys_clock_khz(),
+ * charged as busy time. Zero by default.
+ */
+void shim_clock_set_relock_us(uint32_t us);
+uint32_t shim_clock_khz();
+
+bool shim_watchdog_enabled();
+bool shim_reboot_requested();
+bool shim_usb_boot_requested();
+
+#endif
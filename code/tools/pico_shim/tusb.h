@@ -0,0 +1,86 @@
+#ifndef _SHIM_TUSB_H_
+#define _SHIM_TUSB_H_
+
+// Stand-in for the tinyusb device stack, see tusb_shim.h for the host side.
+// As in tinyusb, every callback into the firmware runs from tud_task(), apart
+// from the SOF hook of application class drivers (device/usbd_pvt.h).
+
+// tinyusb pulls in string.h through tusb_common.h, firmware relies on it.
+#include <string.h>
+
+#include "tusb_config.h"
+#include "class/hid/hid_device.h"
+
+//--------------------------------------------------------------------+
+// Descriptors, as in tinyusb's tusb_types.h and usbd.h
+//--------------------------------------------------------------------+
+typedef struct __attribute__((packed)) {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t bcdUSB;
+    uint8_t bDeviceClass;
+    uint8_t bDeviceSubClass;
+    uint8_t bDeviceProtocol;
+    uint8_t bMaxPacketSize0;
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint16_t bcdDevice;
+    uint8_t iManufacturer;
+    uint8_t iProduct;
+    uint8_t iSerialNumber;
+    uint8_t bNumConfigurations;
+} tusb_desc_device_t;
+
+enum {
+    TUSB_DESC_DEVICE = 0x01,
+    TUSB_DESC_CONFIGURATION = 0x02,
+    TUSB_DESC_STRING = 0x03,
+    TUSB_DESC_INTERFACE = 0x04,
+    TUSB_DESC_ENDPOINT = 0x05,
+};
+
+enum {
+    TUSB_CLASS_HID = 3,
+};
+
+enum {
+    TUSB_XFER_INTERRUPT = 3,
+};
+
+#define TU_U16_LOW(u16) ((uint8_t)((u16) & 0x00ff))
+#define TU_U16_HIGH(u16) ((uint8_t)(((u16) >> 8) & 0x00ff))
+#define U16_TO_U8S_LE(u16) TU_U16_LOW(u16), TU_U16_HIGH(u16)
+
+#define TUD_CONFIG_DESC_LEN (9)
+#define TUD_CONFIG_DESCRIPTOR(config_num, _itfcount, _stridx, _total_len, _attribute, _power_ma) \
+    9, TUSB_DESC_CONFIGURATION, U16_TO_U8S_LE(_total_len), _itfcount, config_num, _stridx, 0x80 | (_attribute), (_power_ma) / 2
+
+#define TUD_HID_DESC_LEN (9 + 9 + 7)
+#define TUD_HID_DESCRIPTOR(_itfnum, _stridx, _boot_protocol, _report_desc_len, _epin, _epsize, _ep_interval) \
+    9, TUSB_DESC_INTERFACE, _itfnum, 0, 1, TUSB_CLASS_HID, (uint8_t)((_boot_protocol) ? HID_SUBCLASS_BOOT : 0), _boot_protocol, _stridx, \
+    9, HID_DESC_TYPE_HID, U16_TO_U8S_LE(0x0111), 0, 1, HID_DESC_TYPE_REPORT, U16_TO_U8S_LE(_report_desc_len), \
+    7, TUSB_DESC_ENDPOINT, _epin, TUSB_XFER_INTERRUPT, U16_TO_U8S_LE(_epsize), _ep_interval
+
+//--------------------------------------------------------------------+
+// Device stack
+//--------------------------------------------------------------------+
+bool tusb_init();
+void tud_task();
+bool tud_mounted();
+bool tud_suspended();
+bool tud_ready();
+void tud_sof_cb_enable(bool en);
+
+// Implemented by the firmware.
+uint8_t const *tud_descriptor_device_cb();
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index);
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid);
+
+// Implemented by the firmware; weak as in tinyusb.
+__attribute__((weak)) void tud_mount_cb();
+__attribute__((weak)) void tud_umount_cb();
+__attribute__((weak)) void tud_suspend_cb(bool remote_wakeup_en);
+__attribute__((weak)) void tud_resume_cb();
+__attribute__((weak)) void tud_sof_cb(uint32_t frame_count);
+
+#endif
@@ -0,0 +1,218 @@
+#include <string.h>
+
+#include <deque>
+
+#include "device/usbd_pvt.h"
+#include "tusb_shim.h"
+
+enum class usb_event : uint8_t {
+    MOUNT,
+    UMOUNT,
+    SUSPEND,
+    RESUME,
+    SOF,
+    COMPLETE,
+    SET_REPORT,
+};
+
+struct queued_event {
+    usb_event type;
+    uint32_t frame;
+    uint8_t report_id;
+    hid_report_type_t report_type;
+    uint16_t len;
+    uint8_t data[64];
+};
+
+static std::deque<queued_event> events;
+static std::vector<shim_usb_report> host_reports;
+
+static bool connected = false;
+static bool mounted = false;
+static bool suspended = false;
+static bool busy = false;
+static bool sof_enabled = false;
+static uint8_t poll_interval = 8;
+static uint32_t frame = 0;
+
+// Report armed on the IN endpoint, with its report ID in front like tinyusb sends it.
+static bool armed = false;
+static uint8_t armed_report[CFG_TUD_HID_EP_BUFSIZE];
+static uint16_t armed_len = 0;
+static uint64_t armed_at = 0;
+
+static void push(usb_event type) {
+    queued_event e = {};
+    e.type = type;
+    e.frame = frame;
+    events.push_back(e);
+}
+
+void shim_usb_reset() {
+    events.clear();
+    host_reports.clear();
+    connected = mounted = suspended = busy = sof_enabled = false;
+    poll_interval = 8;
+    frame = 0;
+    armed = false;
+    armed_len = 0;
+}
+
+//--------------------------------------------------------------------+
+// Bus and host
+//--------------------------------------------------------------------+
+void shim_usb_connect() {
+    connected = true;
+    suspended = false;
+    push(usb_event::MOUNT);
+}
+
+void shim_usb_disconnect() {
+    connected = false;
+    armed = false;
+    push(usb_event::UMOUNT);
+}
+
+void shim_usb_suspend() {
+    if (!connected || suspended) return;
+    suspended = true;
+    push(usb_event::SUSPEND);
+}
+
+void shim_usb_resume() {
+    if (!connected || !suspended) return;
+    suspended = false;
+    push(usb_event::RESUME);
+}
+
+void shim_usb_set_busy(bool b) {
+    busy = b;
+}
+
+void shim_usb_set_poll_interval(uint8_t frames) {
+    poll_interval = frames ? frames : 1;
+}
+
+void shim_usb_set_report(uint8_t report_id, hid_report_type_t type, const uint8_t *buffer, uint16_t len) {
+    queued_event e = {};
+    e.type = usb_event::SET_REPORT;
+    e.report_id = report_id;
+    e.report_type = type;
+    e.len = len < sizeof(e.data) ? len : sizeof(e.data);
+    memcpy(e.data, buffer, e.len);
+    events.push_back(e);
+}
+
+uint16_t shim_usb_get_report(uint8_t report_id, hid_report_type_t type, uint8_t *buffer, uint16_t len) {
+    return tud_hid_get_report_cb(0, report_id, type, buffer, len);
+}
+
+const std::vector<shim_usb_report> &shim_usb_host_reports() {
+    return host_reports;
+}
+
+uint32_t shim_usb_frame() {
+    return frame;
+}
+
+/**
+ * @brief Start of a frame: class driver SOF hooks run straight away, as from
+ * the USB interrupt, the SOF event is queued for tud_task(), and on polling
+ * frames the host takes the armed report, if it is not busy.
+ */
+void shim_usb_frame_tick() {
+    if (!connected || suspended) return;
+    frame = (frame + 1) & 0x7ff;
+    if (sof_enabled) {
+        uint8_t count = 0;
+        usbd_class_driver_t const *drivers = usbd_app_driver_get_cb ? usbd_app_driver_get_cb(&count) : nullptr;
+        for (uint8_t i = 0; i < count; i++) {
+            if (drivers[i].sof) drivers[i].sof(0, frame);
+        }
+        push(usb_event::SOF);
+    }
+
+    if (!armed || busy || frame % poll_interval != 0) return;
+    host_reports.push_back({ armed_at, time_us_64(), armed_report[0], static_cast<uint16_t>(armed_report[1] | (armed_len > 2 ? armed_report[2] << 8 : 0)) });
+    armed = false;
+
+    queued_event e = {};
+    e.type = usb_event::COMPLETE;
+    e.len = armed_len;
+    memcpy(e.data, armed_report, armed_len);
+    events.push_back(e);
+}
+
+//--------------------------------------------------------------------+
+// Device stack
+//--------------------------------------------------------------------+
+bool tusb_init() {
+    return true;
+}
+
+bool tud_mounted() {
+    return mounted;
+}
+
+bool tud_suspended() {
+    return suspended;
+}
+
+bool tud_ready() {
+    return mounted && !suspended;
+}
+
+void tud_sof_cb_enable(bool en) {
+    sof_enabled = en;
+}
+
+bool tud_hid_ready() {
+    return tud_ready() && !armed;
+}
+
+bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len) {
+    if (!tud_hid_ready() || len + 1u > sizeof(armed_report)) return false;
+    armed_report[0] = report_id;
+    memcpy(&armed_report[1], report, len);
+    armed_len = len + 1;
+    armed_at = time_us_64();
+    armed = true;
+    return true;
+}
+
+/**
+ * @brief Runs the callbacks for everything that happened on the bus since
+ * the last call, in order. Weak callbacks the firmware leaves out are
+ * skipped, as tinyusb does.
+ */
+void tud_task() {
+    while (!events.empty()) {
+        queued_event e = events.front();
+        events.pop_front();
+        switch (e.type) {
+            case usb_event::MOUNT:
+                mounted = true;
+                if (tud_mount_cb) tud_mount_cb();
+                break;
+            case usb_event::UMOUNT:
+                mounted = false;
+                if (tud_umount_cb) tud_umount_cb();
+                break;
+            case usb_event::SUSPEND:
+                if (tud_suspend_cb) tud_suspend_cb(false);
+                break;
+            case usb_event::RESUME:
+                if (tud_resume_cb) tud_resume_cb();
+                break;
+            case usb_event::SOF:
+                if (tud_sof_cb) tud_sof_cb(e.frame);
+                break;
+            case usb_event::COMPLETE:
+                tud_hid_report_complete_cb(0, e.data, e.len);
+                break;
+            case usb_event::SET_REPORT:
+                tud_hid_set_report_cb(0, e.report_id, e.report_type, e.data, e.len);
+                break;
+        }
+    }
+}
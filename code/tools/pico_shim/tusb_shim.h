@@ -0,0 +1,52 @@
+#ifndef _TUSB_SHIM_H_
+#define _TUSB_SHIM_H_
+
+// Host and bus side of the tinyusb stand-in. Frames start every 1000 us of
+// simulated time; the host polls the HID IN endpoint every poll interval
+// frames and takes whatever report is armed on it.
+
+#include <vector>
+
+#include "pico/time.h"
+#include "tusb.h"
+
+struct shim_usb_report {
+    uint64_t armed_us;  // When the firmware armed it with tud_hid_report()
+    uint64_t time_us;   // When the host polled it off the endpoint
+    uint8_t id;
+    uint16_t value;
+};
+
+/**
+ * @brief Host enumerates the device; tud_mount_cb() runs on the next tud_task().
+ */
+void shim_usb_connect();
+void shim_usb_disconnect();
+void shim_usb_suspend();
+void shim_usb_resume();
+
+/**
+ * @brief While busy the host stops taking reports off the IN endpoint: an
+ * armed report stays armed and tud_hid_report() keeps refusing new ones.
+ */
+void shim_usb_set_busy(bool busy);
+void shim_usb_set_poll_interval(uint8_t frames);
+
+/**
+ * @brief Host SET_REPORT, handed to the firmware on the next tud_task().
+ */
+void shim_usb_set_report(uint8_t report_id, hid_report_type_t type, const uint8_t *buffer, uint16_t len);
+
+/**
+ * @brief Host GET_REPORT, answered by the firmware straight away.
+ */
+uint16_t shim_usb_get_report(uint8_t report_id, hid_report_type_t type, uint8_t *buffer, uint16_t len);
+
+const std::vector<shim_usb_report> &shim_usb_host_reports();
+uint32_t shim_usb_frame();
+
+// Called by the time simulation at every frame boundary.
+void shim_usb_frame_tick();
+void shim_usb_reset();
+
+#endif
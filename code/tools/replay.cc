@@ -0,0 +1,207 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include <encoder.h>
+#include <hardware/clocks.h>
+
+#include "clock_scale.h"
+#include "fw_update.h"
+#include "input_trace.h"
+#include "replay.h"
+#include "report_pipeline.h"
+#include "ws2812.h"
+
+// From mute_button.cc. Its main() never returns, so the replay runs the
+// same start up and loop itself.
+void input_init();
+void led_task();
+void hid_task();
+
+// The LED is not simulated.
+void neopixel_init(uint, bool) {}
+void put_pixel(uint32_t) {}
+void neopixel_wait_idle() {}
+void neopixel_clock_changed() {}
+
+void replay_add_gpio(std::vector<trace_record> *capture, uint32_t time_us, uint8_t gpio, bool level) {
+    uint16_t value = level ? TRACE_GPIO_LEVEL | TRACE_GPIO_ROSE : TRACE_GPIO_FELL;
+    capture->push_back({ time_us, TRACE_GPIO, gpio, value });
+}
+
+/**
+ * @brief Adds a switch edge that bounces: the pin reaches level at time_us,
+ * then flips at each of the bounce_us offsets and ends up at level.
+ */
+void replay_add_bouncy_edge(std::vector<trace_record> *capture, uint32_t time_us, uint8_t gpio, bool level,
+                            const std::vector<uint32_t> &bounce_us) {
+    replay_add_gpio(capture, time_us, gpio, level);
+    bool l = level;
+    for (uint32_t offs : bounce_us) {
+        l = !l;
+        replay_add_gpio(capture, time_us + offs, gpio, l);
+    }
+    if (l != level) replay_add_gpio(capture, time_us + bounce_us.back() + 1, gpio, level);
+}
+
+std::vector<trace_record> replay_reports(const std::vector<trace_record> &trace) {
+    std::vector<trace_record> out;
+    std::copy_if(trace.begin(), trace.end(), std::back_inserter(out), [](const trace_record &r) { return r.type == TRACE_REPORT; });
+    return out;
+}
+
+/**
+ * @brief Applies one record of the capture. Records the firmware produced
+ * itself, delivered reports, are what the replay checks against instead.
+ */
+static void apply(const trace_record &r) {
+    switch (r.type) {
+        case TRACE_GPIO: {
+            bool level = r.value & TRACE_GPIO_LEVEL;
+            // Both edges in one interrupt: the pin went the other way and back.
+            if ((r.value & TRACE_GPIO_FELL) && (r.value & TRACE_GPIO_ROSE)) shim_gpio_set(r.arg, !level);
+            shim_gpio_set(r.arg, level);
+            break;
+        }
+        case TRACE_ENCODER:
+            shim_encoder_set_position(static_cast<int16_t>(r.value));
+            break;
+        case TRACE_SET_REPORT: {
+            uint8_t value = static_cast<uint8_t>(r.value);
+            shim_usb_set_report(r.arg, HID_REPORT_TYPE_OUTPUT, &value, 1);
+            break;
+        }
+        case TRACE_USB:
+            switch (r.arg) {
+                case TRACE_USB_MOUNT: shim_usb_connect(); break;
+                case TRACE_USB_UMOUNT: shim_usb_disconnect(); break;
+                case TRACE_USB_SUSPEND: shim_usb_suspend(); break;
+                case TRACE_USB_RESUME: shim_usb_resume(); break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Turns the capture and the faults into one time ordered stimulus
+ * list, times relative to the start of the replay.
+ */
+static std::vector<trace_record> make_stimulus(const std::vector<trace_record> &capture, const replay_faults &faults,
+                                               uint32_t start_us) {
+    std::vector<trace_record> s;
+    bool mount_first = false;
+    uint32_t t0 = capture.empty() ? 0 : capture[0].time_us;
+
+    for (const trace_record &r : capture) {
+        // Device output, not stimulus.
+        if (r.type == TRACE_REPORT || r.type == TRACE_ARM) continue;
+        if (r.type == TRACE_USB && s.empty()) mount_first = r.arg == TRACE_USB_MOUNT;
+        trace_record c = r;
+        c.time_us = start_us + (r.time_us - t0);
+        s.push_back(c);
+    }
+    // Captures usually start with the device already mounted.
+    if (!mount_first) s.insert(s.begin(), { 0, TRACE_USB, TRACE_USB_MOUNT, 0 });
+
+    for (uint16_t i = 0; i < faults.burst_count; i++) {
+        uint32_t t = start_us + faults.burst_at_us + i * faults.burst_period_us;
+        replay_add_gpio(&s, t, faults.burst_gpio, false);
+        replay_add_gpio(&s, t + faults.burst_period_us / 2, faults.burst_gpio, true);
+    }
+    std::stable_sort(s.begin(), s.end(), [](const trace_record &a, const trace_record &b) { return a.time_us < b.time_us; });
+    return s;
+}
+
+/**
+ * @brief Moves what the firmware traced so far out of its ring, so long
+ * replays do not overwrite it.
+ */
+static void drain_trace(std::vector<trace_record> *out) {
+    trace_chunk chunk;
+    do {
+        input_trace_get_feature(reinterpret_cast<uint8_t *>(&chunk), sizeof(chunk));
+        out->insert(out->end(), chunk.records, chunk.records + chunk.count);
+    } while (chunk.count > 0);
+}
+
+void replay_run(const std::vector<trace_record> &capture, const replay_faults &faults, replay_result *out) {
+    shim_reset();
+    shim_clock_set_relock_us(faults.pll_relock_us);
+
+    // Same start up as main(), less the LED blinks and bootloader check.
+    fw_update_boot();
+    input_init();
+    tusb_init();
+    tud_sof_cb_enable(true);
+
+    // Give the host time to enumerate before the capture starts.
+    const uint32_t start_us = REPLAY_START_US;
+    std::vector<trace_record> stimulus = make_stimulus(capture, faults, start_us);
+    uint64_t end = (stimulus.empty() ? start_us : stimulus.back().time_us) + REPLAY_SETTLE_US;
+    end = std::max<uint64_t>(end, start_us + faults.busy_at_us + faults.busy_for_us + REPLAY_SETTLE_US);
+    end = std::max<uint64_t>(end, start_us + faults.suspend_at_us + faults.suspend_for_us + REPLAY_SETTLE_US);
+
+    struct timed_fault {
+        uint64_t at;
+        void (*action)();
+    };
+    std::vector<timed_fault> timed;
+    if (faults.busy_for_us) {
+        timed.push_back({ start_us + faults.busy_at_us, [] { shim_usb_set_busy(true); } });
+        timed.push_back({ start_us + faults.busy_at_us + faults.busy_for_us, [] { shim_usb_set_busy(false); } });
+    }
+    if (faults.suspend_for_us) {
+        timed.push_back({ start_us + faults.suspend_at_us, shim_usb_suspend });
+        timed.push_back({ start_us + faults.suspend_at_us + faults.suspend_for_us, shim_usb_resume });
+    }
+    std::sort(timed.begin(), timed.end(), [](const timed_fault &a, const timed_fault &b) { return a.at < b.at; });
+
+    // Clear whatever start up recorded, the replay trace starts with the capture.
+    uint8_t clear = TRACE_CMD_CLEAR;
+    input_trace_set_feature(&clear, 1);
+
+    out->device.clear();
+    size_t next = 0;
+    size_t next_fault = 0;
+    while (shim_time_us() < end) {
+        tud_task();
+        led_task();
+        hid_task();
+        fw_update_task();
+        clock_scale_task(tud_mounted());
+        drain_trace(&out->device);
+
+        // Inputs arrive as interrupts, in the middle of the loop pass.
+        uint64_t until = shim_time_us() + REPLAY_LOOP_US;
+        for (;;) {
+            uint64_t t = until;
+            if (next < stimulus.size()) t = std::min<uint64_t>(t, stimulus[next].time_us);
+            if (next_fault < timed.size()) t = std::min(t, timed[next_fault].at);
+            shim_time_run_until(std::max(t, shim_time_us()));
+            if (next < stimulus.size() && stimulus[next].time_us <= shim_time_us()) {
+                apply(stimulus[next++]);
+            } else if (next_fault < timed.size() && timed[next_fault].at <= shim_time_us()) {
+                timed[next_fault++].action();
+            } else if (shim_time_us() >= until) {
+                break;
+            }
+        }
+    }
+
+    drain_trace(&out->device);
+    out->host = shim_usb_host_reports();
+    memset(out->final_value, 0, sizeof(out->final_value));
+    memset(out->host_value, 0, sizeof(out->host_value));
+    for (uint8_t id : { REPORT_ID_TELEPHONY, REPORT_ID_CONSUMER_CONTROL }) out->final_value[id] = report_pipeline_value(id);
+    for (const shim_usb_report &r : out->host) out->host_value[r.id] = r.value;
+
+    // Drop the mount added for captures taken mid-session, and its resync.
+    out->device.erase(std::remove_if(out->device.begin(), out->device.end(),
+                                     [](const trace_record &r) { return r.time_us < REPLAY_START_US; }),
+                      out->device.end());
+    out->host.erase(std::remove_if(out->host.begin(), out->host.end(),
+                                   [](const shim_usb_report &r) { return r.time_us < REPLAY_START_US; }),
+                    out->host.end());
+}
@@ -0,0 +1,72 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+// Runs an input capture through the firmware's input handling, event queue,
+// hid_task and report pipeline, built for the host against pico_shim. The
+// capture's raw GPIO edges, encoder moves, host reports and bus events are
+// the stimulus; the reports the firmware delivers are the result.
+//
+// The firmware keeps its state in statics, so a process can replay once.
+
+#include <vector>
+
+#include "input_trace_proto.h"
+#include "our_descriptor.h"
+#include "tusb_shim.h"
+
+// Firmware time at which the first record of the capture is replayed. The
+// host enumerates the device before that.
+#define REPLAY_START_US 1000000
+// Time the simulated main loop takes for one pass.
+#define REPLAY_LOOP_US 50
+// How long to keep running after the last record of the capture.
+#define REPLAY_SETTLE_US 200000
+
+/**
+ * @brief Faults injected on top of the capture. Times are relative to the
+ * first record; a zero count or length leaves the fault out.
+ */
+struct replay_faults {
+    // Clean presses on burst_gpio, burst_period_us apart, faster than reports drain.
+    uint8_t burst_gpio;
+    uint16_t burst_count;
+    uint32_t burst_at_us;
+    uint32_t burst_period_us;
+    // Host stops taking reports off the IN endpoint.
+    uint32_t busy_at_us;
+    uint32_t busy_for_us;
+    // Bus suspend and resume.
+    uint32_t suspend_at_us;
+    uint32_t suspend_for_us;
+    // Time the system PLL takes to relock when the clock is raised.
+    uint32_t pll_relock_us;
+};
+
+// The trace and the host reports start at REPLAY_START_US. Captures that start
+// with the device already mounted are replayed from a mount at time zero; it
+// and the resync report it sends stay out of both, as the capture does not
+// have them either.
+struct replay_result {
+    std::vector<trace_record> device;       // Trace the firmware recorded during the replay
+    std::vector<shim_usb_report> host;      // Reports the host took off the endpoint
+    uint16_t final_value[REPORT_ID_COUNT];  // Device side value of each report at the end
+    uint16_t host_value[REPORT_ID_COUNT];   // Last value the host saw of each report
+};
+
+/**
+ * @brief Replays a capture, from firmware start up to REPLAY_SETTLE_US
+ * after its last record.
+ */
+void replay_run(const std::vector<trace_record> &capture, const replay_faults &faults, replay_result *out);
+
+/**
+ * @brief Picks the delivered input reports out of a trace.
+ */
+std::vector<trace_record> replay_reports(const std::vector<trace_record> &trace);
+
+// Stimulus builders, used by the tests to make captures.
+void replay_add_gpio(std::vector<trace_record> *capture, uint32_t time_us, uint8_t gpio, bool level);
+void replay_add_bouncy_edge(std::vector<trace_record> *capture, uint32_t time_us, uint8_t gpio, bool level,
+                            const std::vector<uint32_t> &bounce_us);
+
+#endif
@@ -0,0 +1,57 @@
+// Replays input sequences through the host build of the firmware for each
+// board, see add_host_firmware() in CMakeLists.txt. Runs one case per
+// process under ctest, see replay.h.
+
+#include <gtest/gtest.h>
+
+#include "board_profile.h"
+#include "replay.h"
+
+using Board = board::Current;
+
+static constexpr board::Key first_mute_key() {
+    for (const board::Key &k : Board::KEYS) {
+        if (k.action == board::Action::MUTE) return k;
+    }
+    return {};
+}
+
+static std::vector<uint16_t> host_values(const replay_result &r, uint8_t id) {
+    std::vector<uint16_t> v;
+    for (const shim_usb_report &rep : r.host) {
+        if (rep.id == id) v.push_back(rep.value);
+    }
+    return v;
+}
+
+// Released after a long press with the host not muted, the key sends a
+// press and a release on top of its own release, three events at once.
+// All of them must fit the board's event queue.
+TEST(BoardReplay, LongPressSendsEveryRelease) {
+    const board::Key key = first_mute_key();
+    std::vector<trace_record> c;
+    replay_add_gpio(&c, 0, key.pin, false);
+    replay_add_gpio(&c, 1000000, key.pin, true);
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY), (std::vector<uint16_t>{ 0x01, 0x00, 0x01, 0x00 }));
+    EXPECT_EQ(r.host_value[REPORT_ID_TELEPHONY], r.final_value[REPORT_ID_TELEPHONY]);
+}
+
+// A second press within the long-press window goes off hook first, then
+// the long release again sends its three events.
+TEST(BoardReplay, DoublePressThenLongPress) {
+    const board::Key key = first_mute_key();
+    std::vector<trace_record> c;
+    replay_add_gpio(&c, 0, key.pin, false);
+    replay_add_gpio(&c, 100000, key.pin, true);
+    replay_add_gpio(&c, 250000, key.pin, false);
+    replay_add_gpio(&c, 1250000, key.pin, true);
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY),
+              (std::vector<uint16_t>{ 0x01, 0x00, 0x02, 0x03, 0x02, 0x03, 0x02 }));
+    EXPECT_EQ(r.host_value[REPORT_ID_TELEPHONY], r.final_value[REPORT_ID_TELEPHONY]);
+}
@@ -0,0 +1,173 @@
+// Feeds switch bounce traces to eager_button.cc and to the button library's
+// settle-then-report debouncing side by side, on two pins driven with the
+// same edges. Eager mode must report each press and release exactly once,
+// and sooner. The debouncers keep their state in statics, so run under
+// ctest, one case per process.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <button.h>
+#include <hardware/gpio.h>
+
+#include "board_profile.h"
+#include "eager_button.h"
+#include "pico_shim.h"
+
+#define EAGER_GPIO 19
+#define LIBRARY_GPIO 18
+
+struct reported {
+    uint64_t time_us;
+    bool state;
+};
+
+static std::vector<reported> eager_reports;
+static std::vector<reported> library_reports;
+
+static void eager_onchange(button_t *b) {
+    eager_reports.push_back({ shim_time_us(), b->state });
+}
+
+static void library_onchange(button_t *b) {
+    library_reports.push_back({ shim_time_us(), b->state });
+}
+
+/**
+ * @brief One switch transition: the contact first reaches the new level at
+ * the start, then flips at each offset and ends at the new level.
+ */
+struct bounce_trace {
+    const char *name;
+    uint32_t holdoff_us;
+    std::vector<uint32_t> press_us;
+    std::vector<uint32_t> release_us;
+};
+
+// Offsets in us from the first edge. Kailh keys settle within about 1.5 ms,
+// the encoder's push switch takes several.
+static const bounce_trace TRACES[] = {
+    { "clean", board::KAILH_HOLDOFF_US, {}, {} },
+    { "kailh", board::KAILH_HOLDOFF_US, { 80, 190, 420, 600, 950, 1200 }, { 40, 120, 300 } },
+    { "kailh_worn", board::KAILH_HOLDOFF_US, { 200, 900, 1700, 2600, 3900, 4400 }, { 150, 700, 1500, 2100 } },
+    { "encoder_sw", board::ENCODER_SW_HOLDOFF_US, { 500, 1500, 3000, 4800, 6500, 7100 }, { 300, 1100, 2400, 3300 } },
+};
+
+static void drive(uint64_t start, const std::vector<uint32_t> &bounce, bool level) {
+    shim_time_run_until(start);
+    shim_gpio_set(EAGER_GPIO, level);
+    shim_gpio_set(LIBRARY_GPIO, level);
+    bool l = level;
+    for (uint32_t offs : bounce) {
+        shim_time_run_until(start + offs);
+        l = !l;
+        shim_gpio_set(EAGER_GPIO, l);
+        shim_gpio_set(LIBRARY_GPIO, l);
+    }
+    if (l != level) {
+        shim_time_advance_us(1);
+        shim_gpio_set(EAGER_GPIO, level);
+        shim_gpio_set(LIBRARY_GPIO, level);
+    }
+}
+
+class EagerButton : public ::testing::TestWithParam<bounce_trace> {
+protected:
+    void SetUp() override {
+        shim_reset();
+        eager_reports.clear();
+        library_reports.clear();
+        create_eager_button(EAGER_GPIO, GetParam().holdoff_us, eager_onchange);
+        eager_buttons_enable();
+        create_button(LIBRARY_GPIO, library_onchange);
+    }
+};
+
+TEST_P(EagerButton, ReportsEachEdgeOnceAndSooner) {
+    const bounce_trace &t = GetParam();
+    const uint64_t press_at = 10000;
+    const uint64_t release_at = 200000;
+
+    drive(press_at, t.press_us, false);
+    drive(release_at, t.release_us, true);
+    shim_time_advance_us(100000);
+
+    ASSERT_EQ(eager_reports.size(), 2u) << "phantom or lost edge";
+    EXPECT_FALSE(eager_reports[0].state);
+    EXPECT_TRUE(eager_reports[1].state);
+    ASSERT_EQ(library_reports.size(), 2u);
+
+    uint64_t eager_press = eager_reports[0].time_us - press_at;
+    uint64_t eager_release = eager_reports[1].time_us - release_at;
+    uint64_t library_press = library_reports[0].time_us - press_at;
+    uint64_t library_release = library_reports[1].time_us - release_at;
+    EXPECT_EQ(eager_press, 0u);
+    EXPECT_EQ(eager_release, 0u);
+    EXPECT_GT(library_press, eager_press);
+
+    printf("%-12s press %5llu us -> %llu us, release %5llu us -> %llu us\n", t.name,
+           (unsigned long long)library_press, (unsigned long long)eager_press,
+           (unsigned long long)library_release, (unsigned long long)eager_release);
+    RecordProperty("press_gain_us", static_cast<int>(library_press - eager_press));
+}
+
+TEST_P(EagerButton, TapShorterThanHoldoffIsNotLost) {
+    const bounce_trace &t = GetParam();
+    const uint64_t press_at = 10000;
+    const uint64_t release_at = press_at + t.holdoff_us / 2;
+
+    drive(press_at, {}, false);
+    drive(release_at, {}, true);
+    shim_time_advance_us(100000);
+
+    ASSERT_EQ(eager_reports.size(), 2u);
+    EXPECT_EQ(eager_reports[0].time_us, press_at);
+    // The release is picked up when the hold-off window closes.
+    EXPECT_EQ(eager_reports[1].time_us, press_at + t.holdoff_us);
+}
+
+TEST_P(EagerButton, HeldThroughHoldoffStaysPressed) {
+    const bounce_trace &t = GetParam();
+    drive(10000, t.press_us, false);
+    shim_time_advance_us(t.holdoff_us * 4);
+
+    ASSERT_EQ(eager_reports.size(), 1u);
+    EXPECT_FALSE(eager_reports[0].state);
+}
+
+// Pins work as on the SDK: a raw handler takes its pins from the button
+// library's callback, even if it leaves the events unacknowledged, and no
+// second raw handler can take them.
+static int raw_irq_count = 0;
+
+static void counting_irq() {
+    raw_irq_count++;
+}
+
+TEST(GpioIrq, CallbackSkipsRawHandlerPins) {
+    shim_reset();
+    library_reports.clear();
+    raw_irq_count = 0;
+    create_button(LIBRARY_GPIO, library_onchange);
+    gpio_add_raw_irq_handler_masked(1u << LIBRARY_GPIO, counting_irq);
+
+    shim_time_run_until(10000);
+    shim_gpio_set(LIBRARY_GPIO, false);
+    shim_time_advance_us(100000);
+
+    EXPECT_EQ(raw_irq_count, 1);
+    EXPECT_TRUE(library_reports.empty());
+}
+
+TEST(GpioIrqDeathTest, SecondRawHandlerOnAPinAborts) {
+    shim_reset();
+    create_eager_button(EAGER_GPIO, board::KAILH_HOLDOFF_US, eager_onchange);
+    eager_buttons_enable();
+    EXPECT_DEATH(gpio_add_raw_irq_handler_masked(1u << EAGER_GPIO, counting_irq), "already have a raw handler");
+}
+
+INSTANTIATE_TEST_SUITE_P(Traces, EagerButton, ::testing::ValuesIn(TRACES),
+                         [](const ::testing::TestParamInfo<bounce_trace> &info) { return std::string(info.param.name); });
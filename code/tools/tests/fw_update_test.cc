@@ -0,0 +1,356 @@
+// Drives the update protocol and the loader's slot selection against the
+// flash shim. The firmware keeps its state in statics, so every test runs in
+// a process of its own under ctest, which is also what a reset looks like.
+
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <hardware/flash.h>
+
+#include "board_profile.h"
+#include "fw_meta.h"
+#include "fw_update.h"
+#include "pico_shim.h"
+
+// This build runs from slot A, so updates are staged in slot B.
+#define STAGING_SLOT 1
+
+/**
+ * @brief Builds something the loader accepts as an image for a slot: a
+ * vector table behind the boot2 area and an info block.
+ */
+static std::vector<uint8_t> make_image(size_t size, uint8_t slot, uint8_t board = board::Current::ID) {
+    std::vector<uint8_t> image(size);
+    for (size_t i = 0; i < size; i++) image[i] = static_cast<uint8_t>(i * 7 + 3);
+
+    uint32_t vectors[2] = { SRAM_END, FW_LINK_BASE + FW_SLOT_OFFSET(slot) + 0x201 };
+    memcpy(&image[FW_VECTOR_OFFSET], vectors, sizeof(vectors));
+    fw_image_info info = fw_image_info_make(slot, board);
+    memcpy(&image[0x1c0], &info, sizeof(info));
+    return image;
+}
+
+static uint32_t crc_of(const std::vector<uint8_t> &image) {
+    return fw_crc32(0, image.data(), image.size());
+}
+
+class FwUpdate : public ::testing::Test {
+protected:
+    void SetUp() override {
+        shim_reset();
+        fw_update_boot();
+    }
+
+    fw_status status() {
+        fw_status st;
+        EXPECT_EQ(fw_update_get_feature(reinterpret_cast<uint8_t *>(&st), sizeof(st)), sizeof(st));
+        return st;
+    }
+
+    void begin(uint32_t size, uint32_t crc) {
+        fw_cmd_begin cmd = { FW_CMD_BEGIN, size, crc };
+        fw_update_set_feature(reinterpret_cast<uint8_t *>(&cmd), sizeof(cmd));
+    }
+
+    void data(const std::vector<uint8_t> &image, uint32_t offset) {
+        fw_cmd_data cmd = { FW_CMD_DATA, 0, offset, {} };
+        cmd.len = static_cast<uint8_t>(std::min<size_t>(FW_UPDATE_CHUNK_SIZE, image.size() - offset));
+        memcpy(cmd.data, &image[offset], cmd.len);
+        fw_update_set_feature(reinterpret_cast<uint8_t *>(&cmd), sizeof(cmd));
+    }
+
+    void command(fw_update_cmd c) {
+        uint8_t cmd = c;
+        fw_update_set_feature(&cmd, 1);
+    }
+
+    /**
+     * @brief Sends an image the way mute_update does, running the main loop
+     * after every chunk. Stops early at `stop` bytes.
+     */
+    void send(const std::vector<uint8_t> &image, size_t stop = SIZE_MAX) {
+        begin(image.size(), crc_of(image));
+        for (uint32_t offs = 0; offs < image.size() && offs < stop; offs += FW_UPDATE_CHUNK_SIZE) {
+            data(image, offs);
+            ASSERT_EQ(status().error, FW_ERR_NONE) << "at offset " << offs;
+            fw_update_task();
+        }
+    }
+
+    const uint8_t *staging() {
+        return &shim_flash[FW_SLOT_OFFSET(STAGING_SLOT)];
+    }
+};
+
+TEST_F(FwUpdate, StagesVerifiesAndReboots) {
+    std::vector<uint8_t> image = make_image(3000, STAGING_SLOT);
+    send(image);
+    EXPECT_EQ(status().written, image.size());
+    EXPECT_EQ(memcmp(staging(), image.data(), image.size()), 0);
+
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_READY);
+
+    fw_meta m;
+    ASSERT_TRUE(fw_meta_read(&m));
+    EXPECT_EQ(m.state, MetaState::PENDING);
+    EXPECT_EQ(m.active, 0u);
+
+    command(FW_CMD_REBOOT);
+    fw_update_task();
+    EXPECT_FALSE(shim_reboot_requested());
+    shim_time_advance_us(100 * 1000);
+    fw_update_task();
+    EXPECT_TRUE(shim_reboot_requested());
+}
+
+TEST_F(FwUpdate, ReportsStagingSlot) {
+    EXPECT_EQ(status().staging_slot, STAGING_SLOT);
+}
+
+TEST_F(FwUpdate, RejectsOutOfOrderData) {
+    std::vector<uint8_t> image = make_image(1024, STAGING_SLOT);
+    data(image, 0);
+    EXPECT_EQ(status().error, FW_ERR_STATE);
+
+    begin(image.size(), crc_of(image));
+    data(image, FW_UPDATE_CHUNK_SIZE);
+    EXPECT_EQ(status().error, FW_ERR_SEQUENCE);
+    EXPECT_EQ(status().received, 0u);
+
+    data(image, 0);
+    data(image, 0);
+    EXPECT_EQ(status().error, FW_ERR_SEQUENCE);
+    EXPECT_EQ(status().received, FW_UPDATE_CHUNK_SIZE);
+}
+
+TEST_F(FwUpdate, RejectsDataPastAFullPage) {
+    std::vector<uint8_t> image = make_image(1024, STAGING_SLOT);
+    begin(image.size(), crc_of(image));
+    for (uint32_t offs = 0; offs < FW_UPDATE_PAGE_SIZE; offs += FW_UPDATE_CHUNK_SIZE) data(image, offs);
+
+    // The page has not been programmed yet.
+    data(image, FW_UPDATE_PAGE_SIZE);
+    EXPECT_EQ(status().error, FW_ERR_BUSY);
+
+    fw_update_task();
+    data(image, FW_UPDATE_PAGE_SIZE);
+    EXPECT_EQ(status().error, FW_ERR_NONE);
+}
+
+TEST_F(FwUpdate, RejectsCommitBeforeAllWritten) {
+    std::vector<uint8_t> image = make_image(1024, STAGING_SLOT);
+    send(image, 512);
+    command(FW_CMD_COMMIT);
+    EXPECT_EQ(status().error, FW_ERR_STATE);
+    EXPECT_EQ(status().state, FW_STATE_RECEIVING);
+
+    command(FW_CMD_REBOOT);
+    EXPECT_EQ(status().error, FW_ERR_STATE);
+}
+
+TEST_F(FwUpdate, RejectsOversizedAndUnknown) {
+    begin(FW_SLOT_SIZE + 1, 0);
+    EXPECT_EQ(status().error, FW_ERR_TOO_BIG);
+    EXPECT_EQ(status().state, FW_STATE_IDLE);
+
+    uint8_t cmd = 0x7f;
+    fw_update_set_feature(&cmd, 1);
+    EXPECT_EQ(status().error, FW_ERR_COMMAND);
+
+    cmd = FW_CMD_BEGIN;
+    fw_update_set_feature(&cmd, 1);
+    EXPECT_EQ(status().error, FW_ERR_COMMAND);
+}
+
+TEST_F(FwUpdate, FailsOnCrcMismatch) {
+    std::vector<uint8_t> image = make_image(2000, STAGING_SLOT);
+    begin(image.size(), crc_of(image) ^ 1);
+    for (uint32_t offs = 0; offs < image.size(); offs += FW_UPDATE_CHUNK_SIZE) {
+        data(image, offs);
+        fw_update_task();
+    }
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_ERROR);
+    EXPECT_EQ(status().error, FW_ERR_CRC);
+
+    fw_meta m;
+    EXPECT_FALSE(fw_meta_read(&m));
+    command(FW_CMD_REBOOT);
+    EXPECT_EQ(status().error, FW_ERR_STATE);
+}
+
+TEST_F(FwUpdate, FailsOnImageForOtherSlot) {
+    std::vector<uint8_t> image = make_image(2000, STAGING_SLOT ^ 1);
+    send(image);
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_ERROR);
+    EXPECT_EQ(status().error, FW_ERR_IMAGE);
+}
+
+TEST_F(FwUpdate, FailsOnImageForOtherBoard) {
+    EXPECT_EQ(status().board, board::Current::ID);
+    std::vector<uint8_t> image = make_image(2000, STAGING_SLOT, board::Board<board::Case12, board::MUTE_KEY>::ID);
+    send(image);
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_ERROR);
+    EXPECT_EQ(status().error, FW_ERR_BOARD);
+    fw_meta m;
+    EXPECT_FALSE(fw_meta_read(&m));
+}
+
+TEST_F(FwUpdate, AbortThenRestart) {
+    std::vector<uint8_t> image = make_image(3000, STAGING_SLOT);
+    send(image, 1000);
+    command(FW_CMD_ABORT);
+    EXPECT_EQ(status().state, FW_STATE_IDLE);
+    data(image, 1024);
+    EXPECT_EQ(status().error, FW_ERR_STATE);
+
+    send(image);
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_READY);
+    EXPECT_EQ(memcmp(staging(), image.data(), image.size()), 0);
+}
+
+TEST_F(FwUpdate, BeginRestartsATransfer) {
+    std::vector<uint8_t> first = make_image(3000, STAGING_SLOT);
+    send(first, 1500);
+
+    // Shorter, and different from the first past its info block.
+    std::vector<uint8_t> second = make_image(1200, STAGING_SLOT);
+    second[0x300] ^= 0xff;
+    send(second);
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+    EXPECT_EQ(status().state, FW_STATE_READY);
+    EXPECT_EQ(status().size, second.size());
+    EXPECT_EQ(memcmp(staging(), second.data(), second.size()), 0);
+}
+
+TEST_F(FwUpdate, NewTransferCancelsPendingSwitch) {
+    std::vector<uint8_t> image = make_image(1000, STAGING_SLOT);
+    send(image);
+    command(FW_CMD_COMMIT);
+    fw_update_task();
+
+    send(image, 256);
+    fw_meta m;
+    ASSERT_TRUE(fw_meta_read(&m));
+    EXPECT_EQ(m.state, MetaState::NONE);
+
+    bool trial;
+    EXPECT_EQ(fw_meta_select_slot(&trial), -1);
+}
+
+//--------------------------------------------------------------------+
+// Loader
+//--------------------------------------------------------------------+
+static void flash_image(uint8_t slot, const std::vector<uint8_t> &image) {
+    memcpy(&shim_flash[FW_SLOT_OFFSET(slot)], image.data(), image.size());
+}
+
+static void write_meta(MetaState state, uint8_t active, const std::vector<uint8_t> &staged) {
+    fw_meta m = {};
+    m.state = state;
+    m.active = active;
+    m.size = staged.size();
+    m.crc = crc_of(staged);
+    fw_meta_write(&m);
+}
+
+TEST(FwLoader, StartsSlotAWithoutMetadata) {
+    shim_reset();
+    flash_image(0, make_image(1000, 0));
+    bool trial;
+    EXPECT_EQ(fw_meta_select_slot(&trial), 0);
+    EXPECT_FALSE(trial);
+}
+
+TEST(FwLoader, TriesPendingImageThenRevertsIfNotConfirmed) {
+    shim_reset();
+    std::vector<uint8_t> b = make_image(1000, 1);
+    flash_image(0, make_image(1000, 0));
+    flash_image(1, b);
+    write_meta(MetaState::PENDING, 0, b);
+
+    bool trial;
+    EXPECT_EQ(fw_meta_select_slot(&trial), 1);
+    EXPECT_TRUE(trial);
+
+    // Watchdog reset before the new image confirmed.
+    EXPECT_EQ(fw_meta_select_slot(&trial), 0);
+    EXPECT_FALSE(trial);
+    fw_meta m;
+    fw_meta_read(&m);
+    EXPECT_EQ(m.state, MetaState::REVERTED);
+}
+
+TEST(FwLoader, KeepsConfirmedImage) {
+    shim_reset();
+    std::vector<uint8_t> b = make_image(1000, 1);
+    flash_image(0, make_image(1000, 0));
+    flash_image(1, b);
+    write_meta(MetaState::CONFIRMED, 1, b);
+
+    bool trial;
+    EXPECT_EQ(fw_meta_select_slot(&trial), 1);
+    EXPECT_FALSE(trial);
+}
+
+TEST(FwLoader, IgnoresCorruptStagedImage) {
+    shim_reset();
+    std::vector<uint8_t> b = make_image(1000, 1);
+    flash_image(0, make_image(1000, 0));
+    flash_image(1, b);
+    write_meta(MetaState::PENDING, 0, b);
+    shim_flash[FW_SLOT_OFFSET(1) + 600] ^= 0x10;
+
+    bool trial;
+    EXPECT_EQ(fw_meta_select_slot(&trial), 0);
+    fw_meta m;
+    fw_meta_read(&m);
+    EXPECT_EQ(m.state, MetaState::BAD_IMAGE);
+}
+
+TEST(FwLoader, PowerCutDuringMetadataWriteKeepsPreviousRecord) {
+    // Cut the erase or the program of the new record at various points.
+    for (int cut = 0; cut < 2 * 4; cut++) {
+        shim_reset();
+        std::vector<uint8_t> b = make_image(1000, 1);
+        flash_image(0, make_image(1000, 0));
+        flash_image(1, b);
+        write_meta(MetaState::CONFIRMED, 0, b);
+        write_meta(MetaState::CONFIRMED, 0, b);
+
+        // Erase or program of the PENDING record is cut short.
+        shim_flash_fail_after(cut / 4, (cut % 4) * sizeof(fw_meta) / 4);
+        EXPECT_THROW(write_meta(MetaState::PENDING, 0, b), shim_power_cut);
+
+        shim_flash_fail_after(-1);
+        fw_meta m;
+        ASSERT_TRUE(fw_meta_read(&m)) << "cut " << cut;
+        EXPECT_EQ(m.state, MetaState::CONFIRMED);
+        bool trial;
+        EXPECT_EQ(fw_meta_select_slot(&trial), 0);
+    }
+}
+
+TEST(FwLoader, MetadataWritesAlternateSectors) {
+    shim_reset();
+    std::vector<uint8_t> b = make_image(1000, 1);
+    for (int i = 0; i < 5; i++) write_meta(MetaState::CONFIRMED, i & 1, b);
+    fw_meta m;
+    ASSERT_TRUE(fw_meta_read(&m));
+    EXPECT_EQ(m.seq, 5u);
+    EXPECT_EQ(m.active, 0u);
+    EXPECT_EQ(shim_flash_erase_count(), 5u);
+}
@@ -0,0 +1,241 @@
+// Replays input sequences through the host build of the firmware, clean and
+// with faults injected. Runs one case per process under ctest, see
+// replay.h.
+
+#include <gtest/gtest.h>
+
+#include "replay.h"
+
+#define MUTE_GPIO 19
+#define HOOK_GPIO 21
+
+// Kailh switch bouncing for about 1.2 ms after the contact first closes.
+static const std::vector<uint32_t> KAILH_BOUNCE = { 80, 190, 420, 600, 950, 1200 };
+
+// Reports the host took from the start of the capture on.
+static std::vector<uint16_t> host_values(const replay_result &r, uint8_t id) {
+    std::vector<uint16_t> v;
+    for (const shim_usb_report &rep : r.host) {
+        if (rep.id == id) v.push_back(rep.value);
+    }
+    return v;
+}
+
+static void expect_agreement(const replay_result &r) {
+    EXPECT_EQ(r.host_value[REPORT_ID_TELEPHONY], r.final_value[REPORT_ID_TELEPHONY]);
+    EXPECT_EQ(r.host_value[REPORT_ID_CONSUMER_CONTROL], r.final_value[REPORT_ID_CONSUMER_CONTROL]);
+}
+
+/**
+ * @brief A press of press_us on the mute key, both edges bouncing.
+ */
+static std::vector<trace_record> mute_press(uint32_t at_us, uint32_t press_us) {
+    std::vector<trace_record> c;
+    replay_add_bouncy_edge(&c, at_us, MUTE_GPIO, false, KAILH_BOUNCE);
+    replay_add_bouncy_edge(&c, at_us + press_us, MUTE_GPIO, true, KAILH_BOUNCE);
+    return c;
+}
+
+TEST(Replay, ShortPressTogglesMuteOnce) {
+    replay_result r;
+    replay_run(mute_press(0, 200000), {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY), (std::vector<uint16_t>{ 0x01, 0x00 }));
+    expect_agreement(r);
+}
+
+TEST(Replay, RecordsRawEdges) {
+    replay_result r;
+    std::vector<trace_record> capture = mute_press(0, 200000);
+    replay_run(capture, {}, &r);
+    size_t edges = std::count_if(r.device.begin(), r.device.end(), [](const trace_record &t) { return t.type == TRACE_GPIO; });
+    EXPECT_EQ(edges, capture.size());
+}
+
+TEST(Replay, DoublePressGoesOffHook) {
+    std::vector<trace_record> c = mute_press(0, 100000);
+    std::vector<trace_record> second = mute_press(250000, 100000);
+    c.insert(c.end(), second.begin(), second.end());
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    std::vector<uint16_t> t = host_values(r, REPORT_ID_TELEPHONY);
+    ASSERT_FALSE(t.empty());
+    EXPECT_TRUE(std::find(t.begin(), t.end(), 0x03) != t.end()) << "hook and mute never both set";
+    EXPECT_EQ(t.back() & 0x01, 0);
+    expect_agreement(r);
+}
+
+TEST(Replay, EncoderStepsVolume) {
+    std::vector<trace_record> c;
+    for (int16_t p = 1; p <= 4; p++) c.push_back({ static_cast<uint32_t>(p * 5000), TRACE_ENCODER, 0, static_cast<uint16_t>(p) });
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_CONSUMER_CONTROL),
+              (std::vector<uint16_t>{ HID_USAGE_CONSUMER_VOLUME_INCREMENT, 0x00 }));
+}
+
+TEST(Replay, DeliveredReportsAreTraced) {
+    replay_result r;
+    replay_run(mute_press(0, 200000), {}, &r);
+    std::vector<trace_record> traced = replay_reports(r.device);
+    ASSERT_EQ(traced.size(), r.host.size());
+    for (size_t i = 0; i < traced.size(); i++) {
+        EXPECT_EQ(traced[i].arg, r.host[i].id);
+        EXPECT_EQ(traced[i].value, r.host[i].value);
+    }
+}
+
+// A capture taken mid-session has no mount in it. The mount the replay
+// adds must not show up as a resync report, or the replayed reports would
+// never match the captured ones, as mute_replay compares them.
+TEST(Replay, MidSessionCaptureReplaysItsReports) {
+    std::vector<trace_record> c = mute_press(0, 200000);
+    c.push_back({ 1000, TRACE_REPORT, REPORT_ID_TELEPHONY, 0x01 });
+    c.push_back({ 201000, TRACE_REPORT, REPORT_ID_TELEPHONY, 0x00 });
+    std::stable_sort(c.begin(), c.end(), [](const trace_record &a, const trace_record &b) { return a.time_us < b.time_us; });
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    std::vector<trace_record> expected = replay_reports(c);
+    std::vector<trace_record> got = replay_reports(r.device);
+    ASSERT_EQ(got.size(), expected.size());
+    for (size_t i = 0; i < got.size(); i++) {
+        EXPECT_EQ(got[i].arg, expected[i].arg);
+        EXPECT_EQ(got[i].value, expected[i].value);
+    }
+}
+
+// Simulated frames start on whole milliseconds, so the offset recorded at
+// arming must be the time past the millisecond, and the host must take each
+// report within one poll interval.
+TEST(Replay, ArmOffsetIsTimeIntoFrame) {
+    replay_result r;
+    replay_run(mute_press(0, 200000), {}, &r);
+    std::vector<trace_record> armed;
+    std::copy_if(r.device.begin(), r.device.end(), std::back_inserter(armed),
+                 [](const trace_record &t) { return t.type == TRACE_ARM; });
+    ASSERT_EQ(armed.size(), r.host.size());
+    for (size_t i = 0; i < armed.size(); i++) {
+        EXPECT_EQ(armed[i].arg, r.host[i].id);
+        EXPECT_EQ(armed[i].time_us, r.host[i].armed_us);
+        EXPECT_EQ(armed[i].value, r.host[i].armed_us % 1000);
+        EXPECT_LE(r.host[i].time_us - r.host[i].armed_us, 8000u);
+    }
+}
+
+TEST(Replay, BurstOverflowingTheQueueStillAgrees) {
+    replay_faults f = {};
+    f.burst_gpio = MUTE_GPIO;
+    f.burst_count = 40;
+    f.burst_at_us = 0;
+    f.burst_period_us = 12000;
+
+    replay_result r;
+    replay_run({}, f, &r);
+    std::vector<uint16_t> t = host_values(r, REPORT_ID_TELEPHONY);
+    ASSERT_FALSE(t.empty());
+    EXPECT_EQ(t.back() & 0x01, 0) << "mute left pressed after the burst";
+    expect_agreement(r);
+}
+
+TEST(Replay, BusyEndpointDelaysButKeepsOrder) {
+    replay_faults f = {};
+    f.busy_at_us = 50000;
+    f.busy_for_us = 300000;
+
+    replay_result r;
+    replay_run(mute_press(0, 200000), f, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY), (std::vector<uint16_t>{ 0x01, 0x00 }));
+    ASSERT_EQ(r.host.size(), 2u);
+    EXPECT_GE(r.host[1].time_us, 1000000u + f.busy_at_us + f.busy_for_us);
+    expect_agreement(r);
+}
+
+TEST(Replay, SuspendMidPressReleasesOnResume) {
+    replay_faults f = {};
+    f.suspend_at_us = 100000;
+    f.suspend_for_us = 500000;
+
+    replay_result r;
+    replay_run(mute_press(0, 200000), f, &r);
+    std::vector<uint16_t> t = host_values(r, REPORT_ID_TELEPHONY);
+    ASSERT_FALSE(t.empty());
+    EXPECT_EQ(t.back() & 0x01, 0) << "host still sees mute pressed after resume";
+    expect_agreement(r);
+}
+
+/**
+ * @brief Unplugs the device at at_us and plugs it back in after gap_us.
+ */
+static void add_reconnect(std::vector<trace_record> *c, uint32_t at_us, uint32_t gap_us) {
+    c->push_back({ at_us, TRACE_USB, TRACE_USB_UMOUNT, 0 });
+    c->push_back({ at_us + gap_us, TRACE_USB, TRACE_USB_MOUNT, 0 });
+    std::sort(c->begin(), c->end(), [](const trace_record &a, const trace_record &b) { return a.time_us < b.time_us; });
+}
+
+// Time to agreement: after a reconnect the host must hold the device's
+// state again within one poll interval plus a main loop pass.
+TEST(Replay, ReconnectAgreesWithinOnePoll) {
+    std::vector<trace_record> c = mute_press(0, 100000);
+    std::vector<trace_record> second = mute_press(250000, 100000);
+    c.insert(c.end(), second.begin(), second.end());
+    const uint32_t mount_at = 700000;
+    add_reconnect(&c, 600000, mount_at - 600000);
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    ASSERT_EQ(r.final_value[REPORT_ID_TELEPHONY], 0x02) << "not off hook";
+
+    auto first = std::find_if(r.host.begin(), r.host.end(),
+                              [&](const shim_usb_report &rep) { return rep.time_us >= 1000000u + mount_at; });
+    ASSERT_NE(first, r.host.end()) << "nothing sent after reconnect";
+    EXPECT_EQ(first->id, REPORT_ID_TELEPHONY);
+    EXPECT_EQ(first->value, r.final_value[REPORT_ID_TELEPHONY]);
+    EXPECT_LE(first->time_us - (1000000u + mount_at), 8000u + 1000u);
+    expect_agreement(r);
+}
+
+// The resync after a reconnect leaves out the held mute, but must not lose
+// it: the release is still sent.
+TEST(Replay, ResyncWhileMuteHeldKeepsRelease) {
+    const uint32_t release_at = 400000;
+    std::vector<trace_record> c = mute_press(0, release_at);
+    add_reconnect(&c, 100000, 50000);
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY), (std::vector<uint16_t>{ 0x01, 0x00, 0x00 }));
+    ASSERT_FALSE(r.host.empty());
+    EXPECT_GE(r.host.back().time_us, 1000000u + release_at);
+    expect_agreement(r);
+}
+
+TEST(Replay, HookKeyWithHostCall) {
+    std::vector<trace_record> c;
+    c.push_back({ 0, TRACE_SET_REPORT, REPORT_ID_TELEPHONY, 0x01 });
+    replay_add_bouncy_edge(&c, 50000, HOOK_GPIO, false, KAILH_BOUNCE);
+    replay_add_bouncy_edge(&c, 150000, HOOK_GPIO, true, KAILH_BOUNCE);
+
+    replay_result r;
+    replay_run(c, {}, &r);
+    EXPECT_EQ(host_values(r, REPORT_ID_TELEPHONY), (std::vector<uint16_t>{ 0x02, 0x00 }));
+    expect_agreement(r);
+}
+
+TEST(Replay, ClockBoostDoesNotDelayFirstPress) {
+    replay_faults f = {};
+    f.pll_relock_us = 2000;
+
+    // Well into the LED's idle pause, so the clock is low. The host report
+    // at the start only anchors the capture's time base.
+    const uint32_t press_at = 1500000;
+    std::vector<trace_record> c = { { 0, TRACE_SET_REPORT, REPORT_ID_TELEPHONY, 0x00 } };
+    std::vector<trace_record> press = mute_press(press_at, 200000);
+    c.insert(c.end(), press.begin(), press.end());
+
+    replay_result r;
+    replay_run(c, f, &r);
+    ASSERT_EQ(r.host.size(), 2u);
+    EXPECT_LT(r.host[0].armed_us - (1000000u + press_at), f.pll_relock_us);
+}
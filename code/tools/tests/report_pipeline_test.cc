@@ -0,0 +1,114 @@
+// Drives report_pipeline.cc against the tinyusb stand-in and checks the
+// counters it reports in the stats feature report. The pipeline keeps its
+// state in statics, so run under ctest, one case per process.
+
+#include <gtest/gtest.h>
+
+#include "our_descriptor.h"
+#include "pico_shim.h"
+#include "report_pipeline.h"
+#include "tusb_shim.h"
+
+// The firmware's callbacks, reduced to what the pipeline needs.
+void tud_mount_cb() {
+    report_pipeline_reset();
+}
+
+void tud_sof_cb(uint32_t) {
+    report_pipeline_sof();
+}
+
+void tud_hid_report_complete_cb(uint8_t, uint8_t const* report, uint16_t len) {
+    if (len >= 2) report_pipeline_complete(report[0]);
+}
+
+void tud_hid_set_report_cb(uint8_t, uint8_t, hid_report_type_t, uint8_t const*, uint16_t) {}
+
+uint16_t tud_hid_get_report_cb(uint8_t, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen) {
+    if (report_type == HID_REPORT_TYPE_FEATURE && report_id == REPORT_ID_STATS) {
+        return report_pipeline_get_feature(buffer, reqlen);
+    }
+    return 0;
+}
+
+class ReportPipeline : public ::testing::Test {
+protected:
+    void SetUp() override {
+        shim_reset();
+        tusb_init();
+        tud_sof_cb_enable(true);
+        shim_usb_connect();
+        tud_task();
+    }
+
+    // Reads the counters the way mute_trace -s does.
+    static report_stats stats() {
+        report_stats st = {};
+        EXPECT_EQ(shim_usb_get_report(REPORT_ID_STATS, HID_REPORT_TYPE_FEATURE,
+                                      reinterpret_cast<uint8_t *>(&st), sizeof(st)), sizeof(st));
+        return st;
+    }
+
+    // Runs the main loop once a frame up to the host's next poll of the
+    // endpoint, and handles what the host did.
+    static void poll() {
+        uint64_t until = (shim_time_us() / 8000 + 1) * 8000;
+        while (shim_time_us() < until) {
+            shim_time_run_until((shim_time_us() / 1000 + 1) * 1000);
+            tud_task();
+        }
+    }
+};
+
+TEST_F(ReportPipeline, CountsDeliveredReports) {
+    report_pipeline_stage(REPORT_ID_TELEPHONY, 0x01);
+    report_pipeline_submit();
+    poll();
+    report_pipeline_stage(REPORT_ID_TELEPHONY, 0x00);
+    report_pipeline_submit();
+    poll();
+
+    report_stats st = stats();
+    EXPECT_EQ(st.delivered, 2u);
+    EXPECT_EQ(st.retried, 0u);
+    EXPECT_EQ(shim_usb_host_reports().size(), 2u);
+}
+
+// A transfer in flight at a bus reset never completes; it is sent again
+// and counted once as a retry and once as delivered.
+TEST_F(ReportPipeline, ReportLostToBusResetIsRetried) {
+    report_pipeline_stage(REPORT_ID_TELEPHONY, 0x01);
+    report_pipeline_submit();
+    shim_usb_disconnect();
+    shim_usb_connect();
+    poll();
+
+    report_stats st = stats();
+    EXPECT_EQ(st.retried, 1u);
+    EXPECT_EQ(st.delivered, 1u);
+    ASSERT_EQ(shim_usb_host_reports().size(), 1u);
+    EXPECT_EQ(shim_usb_host_reports()[0].value, 0x01);
+}
+
+// Frames start on whole milliseconds. A report armed 300 us into one lands
+// in the third 125 us bucket, one armed 900 us in in the last; the latency
+// runs to the completion the host's next poll brings.
+TEST_F(ReportPipeline, ArmOffsetAndLatencyOfEachReport) {
+    shim_time_run_until(5300);
+    report_pipeline_stage(REPORT_ID_TELEPHONY, 0x01);
+    report_pipeline_submit();
+    poll();
+    ASSERT_EQ(shim_time_us(), 8000u);
+
+    shim_time_run_until(8900);
+    report_pipeline_stage(REPORT_ID_TELEPHONY, 0x00);
+    report_pipeline_submit();
+    poll();
+
+    report_stats st = stats();
+    EXPECT_EQ(st.delivered, 2u);
+    const uint32_t expected[STATS_OFFSET_BUCKETS] = { 0, 0, 1, 0, 0, 0, 0, 1 };
+    for (uint8_t i = 0; i < STATS_OFFSET_BUCKETS; i++) EXPECT_EQ(st.arm_offset[i], expected[i]) << "bucket " << int(i);
+    EXPECT_EQ(st.latency_us_max, 16000u - 8900u);
+    EXPECT_EQ(st.latency_us_total, (8000u - 5300u) + (16000u - 8900u));
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "trace_file.h"
+
+/**
+ * @brief Writes records to a capture file, header first.
+ */
+bool write_capture(const char *path, const std::vector<trace_record> &records) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    trace_file_header hdr = {};
+    memcpy(hdr.magic, TRACE_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TRACE_FILE_VERSION;
+    hdr.record_size = sizeof(trace_record);
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(records.data(), sizeof(trace_record), records.size(), f) == records.size();
+    fclose(f);
+    return ok;
+}
+
+/**
+ * @brief Reads a capture file written by write_capture().
+ */
+bool read_capture(const char *path, std::vector<trace_record> *out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    trace_file_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr.magic, TRACE_FILE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != TRACE_FILE_VERSION || hdr.record_size != sizeof(trace_record)) {
+        fprintf(stderr, "%s: not a version %d capture\n", path, TRACE_FILE_VERSION);
+        fclose(f);
+        return false;
+    }
+    trace_record r;
+    while (fread(&r, sizeof(r), 1, f) == 1) out->push_back(r);
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef _TRACE_FILE_H_
+#define _TRACE_FILE_H_
+
+// Capture files as written by mute_trace and read by mute_replay.
+
+#include <vector>
+
+#include "input_trace_proto.h"
+
+bool write_capture(const char *path, const std::vector<trace_record> &records);
+bool read_capture(const char *path, std::vector<trace_record> *out);
+
+#endif